@@ -0,0 +1,368 @@
+#include "affinewarp.h"
+#include <QPainter>
+#include <QVector>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr qreal kFixedScale = 65536.0;   // 16.16 sample positions
+constexpr int   kHalfPoint  = 1 << 15;   // half a texel: sample between texel centres
+
+struct Source {
+    const quint32 *bits;
+    int stride;          // in pixels
+    int width, height;
+};
+
+// Texel taps along one axis: clamped neighbours and the 8-bit weight of the second
+struct Taps {
+    int     i0, i1;
+    quint32 w;
+};
+
+static inline Taps tapsFor(int f, int size)
+{
+    const int i = f >> 16;
+    return Taps{ qBound(0, i, size - 1), qBound(0, i + 1, size - 1), quint32(f & 0xFFFF) >> 8 };
+}
+
+// --- Helper: (x * a + y * b) >> 8 per channel, with a + b == 256
+static inline quint32 interpolate256(quint32 x, quint32 a, quint32 y, quint32 b)
+{
+    quint32 t = (x & 0xFF00FFu) * a + (y & 0xFF00FFu) * b;
+    t = (t >> 8) & 0xFF00FFu;
+    x = (((x >> 8) & 0xFF00FFu) * a + ((y >> 8) & 0xFF00FFu) * b) & 0xFF00FF00u;
+    return x | t;
+}
+
+// --- Helper: x * a / 255 per channel, rounded
+static inline quint32 byteMul(quint32 x, quint32 a)
+{
+    quint32 t = (x & 0xFF00FFu) * a;
+    t = ((t + ((t >> 8) & 0xFF00FFu) + 0x800080u) >> 8) & 0xFF00FFu;
+    x = ((x >> 8) & 0xFF00FFu) * a;
+    x = (x + ((x >> 8) & 0xFF00FFu) + 0x800080u) & 0xFF00FF00u;
+    return x | t;
+}
+
+// --- Helper: premultiplied SourceOver
+static inline quint32 sourceOver(quint32 src, quint32 dst)
+{
+    const quint32 a = src >> 24;
+    if (a == 255) return src;
+    return src + byteMul(dst, 255 - a);
+}
+
+static inline quint32 fetchBilinear(const Source &s, int fx, int fy)
+{
+    const Taps tx = tapsFor(fx, s.width);
+    const Taps ty = tapsFor(fy, s.height);
+    const quint32 *r0 = s.bits + ty.i0 * s.stride;
+    const quint32 *r1 = s.bits + ty.i1 * s.stride;
+    const quint32 top = interpolate256(r0[tx.i0], 256 - tx.w, r0[tx.i1], tx.w);
+    const quint32 bot = interpolate256(r1[tx.i0], 256 - tx.w, r1[tx.i1], tx.w);
+    return interpolate256(top, 256 - ty.w, bot, ty.w);
+}
+
+#if defined(__SSE2__)
+
+// --- Helper: per-pixel weights (4 x int32) spread over the 16-bit channel
+//     lanes of pixels 0-1 (lo) and 2-3 (hi)
+static inline void spreadWeights(__m128i w, __m128i *lo, __m128i *hi)
+{
+    w = _mm_shufflelo_epi16(w, _MM_SHUFFLE(2, 2, 0, 0));
+    w = _mm_shufflehi_epi16(w, _MM_SHUFFLE(2, 2, 0, 0));
+    *lo = _mm_unpacklo_epi32(w, w);
+    *hi = _mm_unpackhi_epi32(w, w);
+}
+
+// --- 4 pixels of interpolate256(a, 256 - w, b, w)
+static inline __m128i lerp4(__m128i a, __m128i b, __m128i wLo, __m128i wHi)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c256 = _mm_set1_epi16(256);
+    const __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_sub_epi16(c256, wLo)),
+                                     _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), wLo));
+    const __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_sub_epi16(c256, wHi)),
+                                     _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), wHi));
+    return _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+}
+
+// --- 4 pixels of sourceOver(src, dst)
+static inline __m128i over4(__m128i src, __m128i dst)
+{
+    const __m128i alpha = _mm_srli_epi32(src, 24);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_set1_epi32(255))) == 0xFFFF) return src;
+
+    __m128i iaLo, iaHi;
+    spreadWeights(_mm_sub_epi32(_mm_set1_epi32(255), alpha), &iaLo, &iaHi);
+
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(0x80);
+    __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), iaLo);
+    __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), iaHi);
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), round), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), round), 8);
+    return _mm_add_epi8(src, _mm_packus_epi16(lo, hi));
+}
+
+#endif // __SSE2__
+
+// --- Rotated rows: every pixel walks its own (fx, fy)
+static void blendRowRotated(const Source &s, quint32 *dst, int count, int fx, int fy, int fdx, int fdy)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    alignas(16) quint32 c[4][4];
+    alignas(16) qint32 wx[4], wy[4];
+    for (; i + 4 <= count; i += 4) {
+        // Texel fetches are scalar, the blending is not
+        for (int k = 0; k < 4; ++k, fx += fdx, fy += fdy) {
+            const Taps tx = tapsFor(fx, s.width);
+            const Taps ty = tapsFor(fy, s.height);
+            const quint32 *r0 = s.bits + ty.i0 * s.stride;
+            const quint32 *r1 = s.bits + ty.i1 * s.stride;
+            c[0][k] = r0[tx.i0];
+            c[1][k] = r0[tx.i1];
+            c[2][k] = r1[tx.i0];
+            c[3][k] = r1[tx.i1];
+            wx[k] = qint32(tx.w);
+            wy[k] = qint32(ty.w);
+        }
+
+        __m128i wxLo, wxHi, wyLo, wyHi;
+        spreadWeights(_mm_load_si128(reinterpret_cast<const __m128i *>(wx)), &wxLo, &wxHi);
+        spreadWeights(_mm_load_si128(reinterpret_cast<const __m128i *>(wy)), &wyLo, &wyHi);
+
+        const __m128i top = lerp4(_mm_load_si128(reinterpret_cast<const __m128i *>(c[0])),
+                                  _mm_load_si128(reinterpret_cast<const __m128i *>(c[1])), wxLo, wxHi);
+        const __m128i bot = lerp4(_mm_load_si128(reinterpret_cast<const __m128i *>(c[2])),
+                                  _mm_load_si128(reinterpret_cast<const __m128i *>(c[3])), wxLo, wxHi);
+
+        __m128i *d = reinterpret_cast<__m128i *>(dst + i);
+        _mm_storeu_si128(d, over4(lerp4(top, bot, wyLo, wyHi), _mm_loadu_si128(d)));
+    }
+#endif
+    for (; i < count; ++i, fx += fdx, fy += fdy)
+        dst[i] = sourceOver(fetchBilinear(s, fx, fy), dst[i]);
+}
+
+// --- Separable pass 1: each canvas column blends its two taps of a source row
+static void filterRow(const quint32 *row, const Taps *cols, quint32 *out, int count)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        const Taps *t = cols + i;
+        const __m128i a = _mm_setr_epi32(int(row[t[0].i0]), int(row[t[1].i0]), int(row[t[2].i0]), int(row[t[3].i0]));
+        const __m128i b = _mm_setr_epi32(int(row[t[0].i1]), int(row[t[1].i1]), int(row[t[2].i1]), int(row[t[3].i1]));
+        __m128i wLo, wHi;
+        spreadWeights(_mm_setr_epi32(int(t[0].w), int(t[1].w), int(t[2].w), int(t[3].w)), &wLo, &wHi);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), lerp4(a, b, wLo, wHi));
+    }
+#endif
+    for (; i < count; ++i) {
+        const Taps &t = cols[i];
+        out[i] = interpolate256(row[t.i0], 256 - t.w, row[t.i1], t.w);
+    }
+}
+
+// --- Separable pass 2: blend two filtered rows with one weight, then composite
+static void blendRowSeparable(const quint32 *top, const quint32 *bot, quint32 w, quint32 *dst, int count)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i wv = _mm_set1_epi16(short(w));
+    for (; i + 4 <= count; i += 4) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(top + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bot + i));
+        __m128i *d = reinterpret_cast<__m128i *>(dst + i);
+        _mm_storeu_si128(d, over4(w ? lerp4(a, b, wv, wv) : a, _mm_loadu_si128(d)));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = sourceOver(w ? interpolate256(top[i], 256 - w, bot[i], w) : top[i], dst[i]);
+}
+
+// --- Helper: canvas columns [*first, *last) in the row at cy whose pixel
+//     centres map inside the source, shrunk by mu / mv source units per side
+static bool spanFor(const QTransform &inv, qreal cy, qreal w, qreal h, qreal mu, qreal mv,
+                    int canvasWidth, int *first, int *last)
+{
+    qreal lo = -1.0;
+    qreal hi = canvasWidth + 1.0;
+
+    // min <= slope * cx + offset < max
+    const auto clip = [&](qreal slope, qreal offset, qreal min, qreal max) {
+        if (slope == 0.0) {
+            if (offset < min || offset >= max) hi = lo;
+            return;
+        }
+        qreal a = (min - offset) / slope;
+        qreal b = (max - offset) / slope;
+        if (a > b) std::swap(a, b);
+        lo = qMax(lo, a);
+        hi = qMin(hi, b);
+    };
+    clip(inv.m11(), inv.m21() * cy + inv.dx(), mu, w - mu);
+    clip(inv.m12(), inv.m22() * cy + inv.dy(), mv, h - mv);
+
+    if (!(lo < hi)) return false;
+
+    // Clamp before converting: near-zero slopes put the bounds far outside int range
+    *first = int(std::ceil(qBound<qreal>(0.0, lo - 0.5, canvasWidth)));
+    *last  = int(std::ceil(qBound<qreal>(0.0, hi - 0.5, canvasWidth)));
+    return *first < *last;
+}
+
+// --- Helper: coverage of a pixel centre 't' source units inside [0, size),
+//     with 'g' source units per canvas pixel across the edge
+static inline qreal edgeCoverage(qreal t, qreal size, qreal g)
+{
+    return qBound(0.0, qMin(t, size - t) / g + 0.5, 1.0);
+}
+
+} // namespace
+
+AffineWarp::AffineWarp(const QImage &source)
+    : m_src(source.convertToFormat(QImage::Format_ARGB32_Premultiplied))
+{
+}
+
+void AffineWarp::draw(QImage &canvas, const QTransform &xf, bool smoothEdges) const
+{
+    if (isNull() || canvas.isNull()) return;
+
+    bool invertible = false;
+    const QTransform inv = xf.inverted(&invertible);
+    if (!invertible) return;
+
+    if (!xf.isAffine()) {
+        // Perspective is out of scope here; leave it to the raster engine
+        QPainter p(&canvas);
+        p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        p.setRenderHint(QPainter::Antialiasing, smoothEdges);
+        p.setTransform(xf);
+        p.drawImage(QPointF(0.0, 0.0), m_src);
+        return;
+    }
+
+    if (canvas.format() != QImage::Format_ARGB32_Premultiplied)
+        canvas = canvas.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    const Source s { reinterpret_cast<const quint32 *>(m_src.constBits()),
+                     int(m_src.bytesPerLine() / 4), m_src.width(), m_src.height() };
+    const qreal w = s.width;
+    const qreal h = s.height;
+
+    // Source units per canvas pixel across the u and v edges; the antialiased
+    // outline ramps over half a canvas pixel either side of them
+    const qreal gu = qMax(std::hypot(inv.m11(), inv.m21()), 1e-9);
+    const qreal gv = qMax(std::hypot(inv.m12(), inv.m22()), 1e-9);
+    const qreal outer = smoothEdges ? -0.5 : 0.0;
+    const qreal inner = smoothEdges ?  0.5 : 0.0;
+
+    const QRect rows = bounds(xf) & canvas.rect();
+    if (rows.isEmpty()) return;
+
+    const int fdx = int(inv.m11() * kFixedScale);
+    const int fdy = int(inv.m12() * kFixedScale);
+
+    // No rotation: column taps are the same on every row, and a source row
+    // filtered across them serves every canvas row that reads it
+    const bool separable = (inv.m12() == 0.0 && inv.m21() == 0.0);
+    QVector<Taps> cols;
+    struct FilteredRow { int src = -1; QVector<quint32> px; };
+    FilteredRow filtered[2];
+    int filteredFrom = -1, filteredTo = -1;
+    if (separable) {
+        cols.resize(canvas.width());
+        for (int x = 0; x < canvas.width(); ++x)
+            cols[x] = tapsFor(int((inv.m11() * (x + 0.5) + inv.dx()) * kFixedScale) - kHalfPoint, s.width);
+        for (FilteredRow &f : filtered) f.px.resize(canvas.width());
+    }
+
+    for (int y = rows.top(); y <= rows.bottom(); ++y) {
+        const qreal cy = y + 0.5;
+        int o0, o1;
+        if (!spanFor(inv, cy, w, h, outer * gu, outer * gv, canvas.width(), &o0, &o1)) continue;
+
+        int i0 = o1, i1 = o1;
+        if (spanFor(inv, cy, w, h, inner * gu, inner * gv, canvas.width(), &i0, &i1)) {
+            i0 = qBound(o0, i0, o1);
+            i1 = qBound(i0, i1, o1);
+        } else {
+            i0 = i1 = o1;
+        }
+
+        quint32 *dst = reinterpret_cast<quint32 *>(canvas.scanLine(y));
+
+        // Outline pixels (smoothEdges only): sample scaled by coverage
+        const auto edgePixel = [&](int x) {
+            const qreal cx = x + 0.5;
+            const qreal u = inv.m11() * cx + inv.m21() * cy + inv.dx();
+            const qreal v = inv.m12() * cx + inv.m22() * cy + inv.dy();
+            const quint32 a = quint32(qRound(edgeCoverage(u, w, gu) * edgeCoverage(v, h, gv) * 255.0));
+            if (!a) return;
+            const quint32 px = fetchBilinear(s, int(u * kFixedScale) - kHalfPoint, int(v * kFixedScale) - kHalfPoint);
+            dst[x] = sourceOver(a == 255 ? px : byteMul(px, a), dst[x]);
+        };
+        for (int x = o0; x < i0; ++x) edgePixel(x);
+        for (int x = i1; x < o1; ++x) edgePixel(x);
+        if (i0 == i1) continue;
+
+        if (separable) {
+            if (i0 != filteredFrom || i1 != filteredTo) {
+                for (FilteredRow &f : filtered) f.src = -1;
+                filteredFrom = i0;
+                filteredTo   = i1;
+            }
+            // Filtered copy of source row 'src', evicting the slot not holding 'keep'
+            const auto filteredRow = [&](int src, int keep) -> const quint32 * {
+                for (const FilteredRow &f : filtered)
+                    if (f.src == src) return f.px.constData();
+                FilteredRow &f = (filtered[0].src == keep) ? filtered[1] : filtered[0];
+                f.src = src;
+                filterRow(s.bits + src * s.stride, cols.constData() + i0, f.px.data(), i1 - i0);
+                return f.px.constData();
+            };
+
+            const Taps ty = tapsFor(int((inv.m22() * cy + inv.dy()) * kFixedScale) - kHalfPoint, s.height);
+            const quint32 *top = filteredRow(ty.i0, ty.i1);
+            const quint32 *bot = ty.w ? filteredRow(ty.i1, ty.i0) : top;
+            blendRowSeparable(top, bot, ty.w, dst + i0, i1 - i0);
+        } else {
+            const qreal cx = i0 + 0.5;
+            const int fx = int((inv.m11() * cx + inv.m21() * cy + inv.dx()) * kFixedScale) - kHalfPoint;
+            const int fy = int((inv.m12() * cx + inv.m22() * cy + inv.dy()) * kFixedScale) - kHalfPoint;
+            blendRowRotated(s, dst + i0, i1 - i0, fx, fy, fdx, fdy);
+        }
+    }
+}
+
+void AffineWarp::draw(QImage &canvas, const QRect &target) const
+{
+    if (isNull() || target.isEmpty()) return;
+    draw(canvas, toTarget(target));
+}
+
+QTransform AffineWarp::toTarget(const QRect &target) const
+{
+    QTransform xf;
+    xf.translate(target.x(), target.y());
+    xf.scale(qreal(target.width()) / m_src.width(), qreal(target.height()) / m_src.height());
+    return xf;
+}
+
+// The mapped source rectangle, plus a pixel for the antialiased outline
+QRect AffineWarp::bounds(const QTransform &xf) const
+{
+    if (isNull()) return QRect();
+    return xf.mapRect(QRectF(0.0, 0.0, m_src.width(), m_src.height())).toAlignedRect().adjusted(-1, -1, 1, 1);
+}
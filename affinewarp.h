@@ -0,0 +1,50 @@
+#ifndef AFFINEWARP_H
+#define AFFINEWARP_H
+
+#include <QImage>
+#include <QTransform>
+
+// Scale + rotate resampler for the spin, yaw, flip, oscillate and composite
+// generators. It replaces QPainter::drawImage() with SmoothPixmapTransform,
+// whose per-call setup cost dominated those loops.
+//
+// The source is converted to premultiplied ARGB32 once, at construction; after
+// that draw() is const and may run on several threads at once.
+//
+// Sampling follows Qt's raster engine: the canvas pixel centre is mapped back
+// through the inverse transform, texels are clamped at the source edges, and
+// weights are 8-bit in 16.16 fixed point. The result is composited SourceOver.
+// Two row paths:
+//  - no rotation (pure yaw/flip squash): separable, the two source rows are
+//    blended once per canvas row and each column's taps come from a table;
+//  - rotation: general bilinear, 4 pixels per step in SSE2.
+// Output matches QPainter within +/-1 per channel. Rounding differs slightly
+// on the separable path, and the antialiased outline is an approximation.
+class AffineWarp
+{
+public:
+    explicit AffineWarp(const QImage &source);
+
+    bool isNull() const { return m_src.isNull(); }
+    QSize size() const { return m_src.size(); }
+
+    // Draws the source over 'canvas' through 'xf' (source pixels -> canvas
+    // pixels), like QPainter::setTransform(xf) + drawImage(source.rect()).
+    // smoothEdges gives the outline partial coverage (QPainter::Antialiasing)
+    // instead of the hard pixel-centre test.
+    void draw(QImage &canvas, const QTransform &xf, bool smoothEdges = false) const;
+
+    // Draws the source scaled into 'target', like QPainter::drawImage(target, source)
+    void draw(QImage &canvas, const QRect &target) const;
+
+    // Canvas pixels the matching draw() call may touch (outline included)
+    QRect bounds(const QTransform &xf) const;
+    QRect bounds(const QRect &target) const { return bounds(toTarget(target)); }
+
+private:
+    QTransform toTarget(const QRect &target) const;
+
+    QImage m_src;   // ARGB32_Premultiplied
+};
+
+#endif // AFFINEWARP_H
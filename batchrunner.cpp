@@ -0,0 +1,415 @@
+#include "batchrunner.h"
+#include "runprofile.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+typedef QHash<QString, QString> Fields;
+
+// --- Helper: split one CSV line; double quotes group commas, "" is a quote
+static QStringList splitCsvLine(const QString &line)
+{
+    QStringList cells;
+    QString cell;
+    bool quoted = false;
+    for (int i = 0; i < line.size(); ++i) {
+        const QChar c = line.at(i);
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line.at(i + 1) == '"') { cell += '"'; ++i; }
+            else if (c == '"') quoted = false;
+            else cell += c;
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            cells << cell.trimmed();
+            cell.clear();
+        } else {
+            cell += c;
+        }
+    }
+    cells << cell.trimmed();
+    return cells;
+}
+
+static bool readCsv(const QByteArray &data, QList<Fields> *rowsOut, QString *errOut)
+{
+    QStringList header;
+    int lineNo = 0;
+    for (QString line : QString::fromUtf8(data).split('\n')) {
+        ++lineNo;
+        line = line.trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        const QStringList cells = splitCsvLine(line);
+        if (header.isEmpty()) { header = cells; continue; }
+        if (cells.size() > header.size()) {
+            if (errOut) *errOut = QStringLiteral("Line %1: more cells than header columns.").arg(lineNo);
+            return false;
+        }
+        Fields row;
+        for (int c = 0; c < cells.size(); ++c)
+            if (!cells[c].isEmpty()) row.insert(header[c], cells[c]);
+        rowsOut->append(row);
+    }
+    return true;
+}
+
+// --- Helper: JSON scalar as the text a CSV cell would hold
+static QString jsonText(const QJsonValue &v)
+{
+    if (v.isBool())   return v.toBool() ? QStringLiteral("true") : QStringLiteral("false");
+    if (v.isDouble()) return QString::number(v.toDouble(), 'g', 15);
+    if (v.isArray()) {   // e.g. "outputSizes": [128, 256]
+        QStringList parts;
+        for (const QJsonValue &e : v.toArray()) parts << jsonText(e);
+        return parts.join(',');
+    }
+    return v.toString();
+}
+
+static bool readJson(const QByteArray &data, QList<Fields> *rowsOut, QString *errOut)
+{
+    QJsonParseError perr;
+    const QJsonDocument doc = QJsonDocument::fromJson(data, &perr);
+    if (doc.isNull()) {
+        if (errOut) *errOut = QStringLiteral("Invalid JSON: %1").arg(perr.errorString());
+        return false;
+    }
+    const QJsonArray list = doc.isArray() ? doc.array() : doc.object().value("jobs").toArray();
+    for (const QJsonValue &v : list) {
+        if (!v.isObject()) {
+            if (errOut) *errOut = QStringLiteral("Every job must be a JSON object.");
+            return false;
+        }
+        const QJsonObject o = v.toObject();
+        Fields row;
+        for (const QString &key : o.keys())
+            row.insert(key, jsonText(o.value(key)));
+        rowsOut->append(row);
+    }
+    return true;
+}
+
+// --- Helper: typed field readers; a missing field keeps the default
+static bool readInt(const Fields &f, const QString &key, int *out, QString *errOut)
+{
+    if (!f.contains(key)) return true;
+    bool ok = false;
+    const int v = f.value(key).toInt(&ok);
+    if (!ok) { if (errOut) *errOut = QStringLiteral("'%1' is not an integer.").arg(key); return false; }
+    *out = v;
+    return true;
+}
+
+static bool readReal(const Fields &f, const QString &key, double *out, QString *errOut)
+{
+    if (!f.contains(key)) return true;
+    bool ok = false;
+    const double v = f.value(key).toDouble(&ok);
+    if (!ok) { if (errOut) *errOut = QStringLiteral("'%1' is not a number.").arg(key); return false; }
+    *out = v;
+    return true;
+}
+
+static bool jobFromFields(const Fields &f, const QDir &baseDir, BatchRunner::Job *job, QString *errOut)
+{
+    auto path = [&](const QString &key) {
+        const QString p = f.value(key).trimmed();
+        return p.isEmpty() ? p : QDir::cleanPath(baseDir.absoluteFilePath(p));
+    };
+    job->source = path("source");
+    job->back   = path("back");
+    job->output = path("output");
+    if (job->source.isEmpty() || job->output.isEmpty()) {
+        if (errOut) *errOut = QStringLiteral("'source' and 'output' are required.");
+        return false;
+    }
+
+    if (f.contains("mode") && !job->setMode(f.value("mode"), errOut)) return false;
+
+    if (!readInt (f, "fps",            &job->fps,            errOut)) return false;
+    if (!readReal(f, "duration",       &job->duration,       errOut)) return false;
+    if (!readInt (f, "size",           &job->size,           errOut)) return false;
+    if (!readReal(f, "yawRotations",   &job->yawRotations,   errOut)) return false;
+    if (!readInt (f, "flipCycles",     &job->flipCycles,     errOut)) return false;
+    if (!readReal(f, "maxDegrees",     &job->maxDegrees,     errOut)) return false;
+    if (!readReal(f, "globeRotations", &job->globeRotations, errOut)) return false;
+    if (!readReal(f, "globeZoom",      &job->globeZoom,      errOut)) return false;
+    job->fps        = qBound(1, job->fps, 100);
+    job->duration   = qMax(0.10, job->duration);
+    job->size       = qBound(job->minSize(), job->size, 4096);
+    job->flipCycles = qMax(1, job->flipCycles);
+
+    if (f.contains("bg")) {
+        const QString bg = f.value("bg").trimmed();
+        job->bg = (bg.compare("transparent", Qt::CaseInsensitive) == 0) ? QColor(Qt::transparent) : QColor(bg);
+        if (!job->bg.isValid()) { if (errOut) *errOut = QStringLiteral("Invalid bg color '%1'.").arg(bg); return false; }
+    }
+
+    if (f.contains("globeAxis")) {
+        const QString axis = f.value("globeAxis").trimmed().toLower();
+        if      (axis == "horizontal" || axis == "0") job->globeAxis = 0;
+        else if (axis == "vertical"   || axis == "1") job->globeAxis = 1;
+        else if (axis == "both"       || axis == "2") job->globeAxis = 2;
+        else { if (errOut) *errOut = QStringLiteral("Invalid globeAxis '%1'.").arg(axis); return false; }
+    }
+
+    if (f.contains("crop")) {
+        const QString crop = f.value("crop").trimmed().toLower();
+        job->crop = (crop == "1" || crop == "true" || crop == "yes");
+    }
+
+    if (f.contains("outputSizes")) {
+        bool ok = false;
+        job->outputSizes = GifEngine::parseSizeList(f.value("outputSizes"), &ok);
+        if (!ok) { if (errOut) *errOut = QStringLiteral("Invalid outputSizes '%1'.").arg(f.value("outputSizes")); return false; }
+    }
+
+    if (f.contains("backside")) {
+        const QString b = f.value("backside").trimmed().toLower();
+        if      (b == "off")         job->backside = GifEngine::BacksideOff;
+        else if (b == "normal")      job->backside = GifEngine::BacksideNormal;
+        else if (b == "upside-down") job->backside = GifEngine::BacksideUpsideDown;
+        else { if (errOut) *errOut = QStringLiteral("Invalid backside '%1'.").arg(b); return false; }
+    }
+    return true;
+}
+
+} // namespace
+
+bool BatchRunner::Job::setMode(const QString &modes, QString *errOut)
+{
+    spin = yaw = flip = oscillate = globe = false;
+    for (const QString &m : modes.toLower().split(',', Qt::SkipEmptyParts)) {
+        const QString mode = m.trimmed();
+        if      (mode == "spin")      spin      = true;
+        else if (mode == "yaw")       yaw       = true;
+        else if (mode == "flip")      flip      = true;
+        else if (mode == "oscillate") oscillate = true;
+        else if (mode == "globe")     globe     = true;
+        else {
+            if (errOut) *errOut = QStringLiteral("Unknown mode '%1'.").arg(mode);
+            return false;
+        }
+    }
+    if (int(spin || yaw || flip) + int(oscillate) + int(globe) != 1) {
+        if (errOut) *errOut = QStringLiteral("Mode takes spin/yaw/flip (combinable), oscillate, or globe.");
+        return false;
+    }
+    return true;
+}
+
+double BatchRunner::Job::estimatedCost() const
+{
+    // Globe frames are ray-cast per pixel, several times the cost of a warp
+    const double frames = GifEngine::frameCount(fps, duration);
+    int px = size;
+    for (int extra : outputSizes) px = qMax(px, extra);   // rendered at the largest
+    return frames * double(px) * px * (globe ? 4.0 : 1.0);
+}
+
+bool BatchRunner::loadManifest(const QString &path, QVector<Job> *jobsOut, QString *errOut)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errOut) *errOut = QStringLiteral("Cannot open manifest: %1").arg(path);
+        return false;
+    }
+    const QByteArray data = file.readAll();
+
+    QList<Fields> rows;
+    const bool csv = QFileInfo(path).suffix().compare("csv", Qt::CaseInsensitive) == 0;
+    if (!(csv ? readCsv(data, &rows, errOut) : readJson(data, &rows, errOut))) return false;
+
+    const QDir baseDir(QFileInfo(path).absolutePath());
+    jobsOut->clear();
+    for (int i = 0; i < rows.size(); ++i) {
+        Job job;
+        QString err;
+        if (!jobFromFields(rows[i], baseDir, &job, &err)) {
+            if (errOut) *errOut = QStringLiteral("Job %1: %2").arg(i + 1).arg(err);
+            return false;
+        }
+        jobsOut->append(job);
+    }
+    if (jobsOut->isEmpty()) {
+        if (errOut) *errOut = QStringLiteral("Manifest has no jobs: %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+// The job's back/crop/backside fields override the engine's options
+bool BatchRunner::runJob(GifEngine &engine, const Job &job, QString *errOut)
+{
+    if (job.source.isEmpty() || !QFileInfo::exists(job.source)) {
+        if (errOut) *errOut = QStringLiteral("Source image not found: %1").arg(job.source);
+        return false;
+    }
+    if (job.output.isEmpty()) {
+        if (errOut) *errOut = QStringLiteral("No output path.");
+        return false;
+    }
+
+    GifEngine::Options opts = engine.options();
+    if (!job.back.isEmpty()) opts.backImagePath = job.back;
+    if (job.crop)            opts.cropToContent = true;
+    if (job.backside >= 0)   opts.backsideMode  = GifEngine::BacksideMode(job.backside);
+    if (!job.outputSizes.isEmpty()) opts.outputSizes = job.outputSizes;
+    engine.setOptions(opts);
+
+    // Same duration handling as the generate button
+    const double durationSec = GifEngine::frameCount(job.fps, job.duration) / double(job.fps);
+    const double zDegPerSec  = 360.0 / durationSec;
+
+    if (job.globe) {
+        return engine.generateGlobeGif(job.source, QString(), job.output,
+                                       job.fps, durationSec, job.size,
+                                       job.globeRotations, job.globeZoom, job.globeAxis,
+                                       job.bg, errOut);
+    }
+    if (job.oscillate) {
+        return engine.generateOscillateGif(job.source, job.output, job.fps, durationSec, job.size,
+                                           job.maxDegrees, job.bg, errOut);
+    }
+    return engine.generateCompositeGif(job.source, job.output, job.fps, durationSec, job.size,
+                                       job.spin, zDegPerSec,
+                                       job.yaw,  job.yawRotations,
+                                       job.flip, job.flip, job.flipCycles,
+                                       job.bg, errOut);
+}
+
+QJsonObject BatchRunner::describe(const Job &job, const Result &result)
+{
+    QStringList modes;
+    if (job.globe)          modes << "globe";
+    else if (job.oscillate) modes << "oscillate";
+    else {
+        if (job.spin) modes << "spin";
+        if (job.yaw)  modes << "yaw";
+        if (job.flip) modes << "flip";
+    }
+
+    QJsonObject o;
+    o.insert("source", job.source);
+    o.insert("output", job.output);
+    o.insert("mode", modes.join(','));
+    o.insert("fps", job.fps);
+    o.insert("duration", job.duration);
+    o.insert("size", job.size);
+    if (!job.outputSizes.isEmpty()) {
+        QJsonArray sizes;
+        for (int px : job.outputSizes) sizes.append(px);
+        o.insert("outputSizes", sizes);
+    }
+    o.insert("ok", result.ok);
+    if (!result.ok) o.insert("error", result.error);
+    o.insert("frames", result.frames);
+    o.insert("seconds", result.seconds);
+    return o;
+}
+
+BatchRunner::Stats BatchRunner::run(const QVector<Job> &jobs)
+{
+    Stats st;
+    st.jobs = jobs.size();
+    st.results.resize(jobs.size());
+    if (jobs.isEmpty()) return st;
+
+    // One pool for every job's frames
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, m_base.renderThreads));
+    GifEngine::Options base = m_base;
+    base.renderPool = &pool;
+
+    // Largest first; each job driver takes the next one when it is done
+    QVector<int> order(jobs.size());
+    for (int i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return jobs[a].estimatedCost() > jobs[b].estimatedCost();
+    });
+
+    Result *results = st.results.data();
+    std::atomic<int> next(0);
+    auto drive = [&]{
+        for (;;) {
+            const int k = next.fetch_add(1);
+            if (k >= order.size()) return;
+            const int index = order[k];
+
+            GifEngine engine(base);
+            if (m_logger) engine.setLogger(m_logger);
+            RunProfile profile;
+            profile.setTracing(!m_traceDir.isEmpty());
+            engine.setProfile(&profile);
+
+            QElapsedTimer timer;
+            timer.start();
+            Result r;
+            r.ok      = runJob(engine, jobs[index], &r.error);
+            r.frames  = engine.lastFrameCount();
+            r.seconds = timer.elapsed() / 1000.0;
+            profile.stop();
+            r.timing  = profile.summary();
+
+            // Numbered like the job messages: outputs in different folders
+            // may share a base name, and the reports must not overwrite each other
+            const QString stem = QStringLiteral("%1_%2").arg(index + 1, 3, 10, QChar('0'))
+                                     .arg(QFileInfo(jobs[index].output).completeBaseName());
+            if (!m_reportDir.isEmpty()) {
+                const QString name = stem + ".json";
+                QString reportErr;
+                if (!profile.writeJson(QDir(m_reportDir).filePath(name), describe(jobs[index], r), &reportErr)
+                    && m_logger)
+                    m_logger(reportErr);
+            }
+            if (!m_traceDir.isEmpty()) {
+                const QString name = stem + ".trace.json";
+                QString traceErr;
+                if (!profile.writeTrace(QDir(m_traceDir).filePath(name), &traceErr) && m_logger)
+                    m_logger(traceErr);
+            }
+            results[index] = r;
+            if (m_jobFinished) m_jobFinished(index, r);
+        }
+    };
+
+    if (!m_reportDir.isEmpty()) QDir().mkpath(m_reportDir);
+    if (!m_traceDir.isEmpty())  QDir().mkpath(m_traceDir);
+
+    QElapsedTimer wall;
+    wall.start();
+
+    // Job drivers mostly wait on the pool and their encoder thread, so they
+    // are plain threads rather than pool workers (a driver must never occupy
+    // a slot its own frames need).
+    QVector<QThread *> drivers;
+    const int driverCount = qMin(concurrentJobs(), int(jobs.size()));
+    for (int d = 0; d < driverCount; ++d) {
+        QThread *t = QThread::create(drive);
+        t->start();
+        drivers.append(t);
+    }
+    for (QThread *t : drivers) {
+        t->wait();
+        delete t;
+    }
+
+    st.seconds = wall.elapsed() / 1000.0;
+    for (const Result &r : st.results) {
+        if (!r.ok) ++st.failed;
+        st.frames += r.frames;
+    }
+    return st;
+}
@@ -0,0 +1,137 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QString>
+#include <QColor>
+#include <QJsonObject>
+#include <QVector>
+#include <functional>
+#include "gifengine.h"
+
+// Runs many GifEngine jobs at once, e.g. a whole product catalog.
+//
+// Jobs come from a manifest (see loadManifest()). Several jobs run
+// concurrently, and all of them render their frames on ONE shared thread
+// pool. An idle core picks up the next frame from whichever job has work
+// queued, so a long globe job never keeps the cores from the short spin jobs
+// behind it (and vice versa). Jobs are started largest-first by estimated
+// cost, so the longest one does not begin last and hold up the end of the run.
+//
+// Each job still has its own encoder thread, and its output is identical to
+// a single run with the same parameters.
+//
+//   QVector<BatchRunner::Job> jobs;
+//   if (!BatchRunner::loadManifest("catalog.json", &jobs, &err)) ...
+//   BatchRunner runner;
+//   const BatchRunner::Stats st = runner.run(jobs);
+class BatchRunner
+{
+public:
+    // One GIF: every parameter of the generate button / gifstew-cli
+    struct Job {
+        QString source;
+        QString back;                 // explicit back face (optional)
+        QString output;
+
+        // Mode: any of spin/yaw/flip (combined), or oscillate, or globe
+        bool spin = true, yaw = false, flip = false;
+        bool oscillate = false, globe = false;
+
+        int    fps            = 24;
+        double duration       = 1.0;  // seconds per revolution (fractional)
+        int    size           = 512;
+        QColor bg             = Qt::transparent;
+        double yawRotations   = 1.0;
+        int    flipCycles     = 1;
+        double maxDegrees     = 15.0;
+        double globeRotations = 1.0;
+        double globeZoom      = 100.0;
+        int    globeAxis      = 0;    // 0 horizontal, 1 vertical, 2 both
+        bool   crop           = false;
+        int    backside       = -1;   // GifEngine::BacksideMode, -1 = base options
+        QList<int> outputSizes;       // more sizes from the same render, empty = base options
+
+        // "spin,yaw", "oscillate", "globe", ...; false + *errOut if invalid
+        bool setMode(const QString &modes, QString *errOut);
+
+        // Smallest 'size' the generator takes as given (it substitutes its
+        // default below this): 64 for globe, 32 otherwise
+        int minSize() const { return globe ? 64 : 32; }
+
+        // Rough relative render cost (frames x pixels), for scheduling only
+        double estimatedCost() const;
+    };
+
+    struct Result {
+        bool    ok = false;
+        QString error;
+        int     frames = 0;
+        double  seconds = 0.0;
+        QString timing;          // RunProfile::summary() of the job
+    };
+
+    struct Stats {
+        int    jobs = 0;
+        int    failed = 0;
+        qint64 frames = 0;
+        double seconds = 0.0;    // wall clock for the whole batch
+        QVector<Result> results; // same order as the input jobs
+
+        double jobsPerSec()   const { return seconds > 0 ? jobs / seconds : 0.0; }
+        double framesPerSec() const { return seconds > 0 ? frames / seconds : 0.0; }
+    };
+
+    // Reads a JSON or CSV manifest (by extension; anything but .csv is JSON).
+    //  JSON: [ {"source": ..., "output": ..., "mode": "spin,yaw", "fps": 24, ...}, ... ]
+    //        or {"jobs": [ ... ]}
+    //  CSV:  header row naming the columns, one job per row
+    // Keys: source, back, output, mode, fps, duration, size, bg, yawRotations,
+    //       flipCycles, maxDegrees, globeRotations, globeZoom, globeAxis,
+    //       crop, backside, outputSizes ("128,256": written as
+    //       <output>_<px>.gif). Relative paths are taken from the manifest's folder.
+    static bool loadManifest(const QString &path, QVector<Job> *jobsOut, QString *errOut);
+
+    // Renders one job with 'engine' (whose options supply the defaults)
+    static bool runJob(GifEngine &engine, const Job &job, QString *errOut);
+
+    // Job parameters and outcome, the header of a job's timing report
+    static QJsonObject describe(const Job &job, const Result &result);
+
+    // Defaults for every job: render threads (= shared pool size), palette,
+    // optimizer, backside mode, output sizes. Per-job fields override
+    // back/crop/backside/outputSizes.
+    void setBaseOptions(const GifEngine::Options &options) { m_base = options; }
+    const GifEngine::Options &baseOptions() const { return m_base; }
+
+    // Jobs rendering at the same time; 0 (default) = half the render threads,
+    // min 2, enough to keep the pool fed while each job encodes.
+    void setConcurrentJobs(int jobs) { m_concurrent = qMax(0, jobs); }
+    int  concurrentJobs() const { return m_concurrent > 0 ? m_concurrent : qMax(2, m_base.renderThreads / 2); }
+
+    // Called (from worker threads) as each job finishes: index into 'jobs'
+    void setJobFinished(const std::function<void(int, const Result &)> &cb) { m_jobFinished = cb; }
+
+    // Engine diagnostics; may be called from several threads at once
+    void setLogger(const std::function<void(const QString &)> &logger) { m_logger = logger; }
+
+    // Write each job's per-stage timing report (RunProfile JSON) to this
+    // folder as <job number>_<output base name>.json, e.g. 001_logo.json;
+    // empty (default) = no reports
+    void setReportDir(const QString &dir) { m_reportDir = dir; }
+
+    // Record each job's timeline and write it to this folder as
+    // <job number>_<output base name>.trace.json (Chrome trace events); empty = off
+    void setTraceDir(const QString &dir) { m_traceDir = dir; }
+
+    Stats run(const QVector<Job> &jobs);
+
+private:
+    GifEngine::Options m_base;
+    int m_concurrent = 0;
+    std::function<void(int, const Result &)> m_jobFinished;
+    std::function<void(const QString &)>     m_logger;
+    QString m_reportDir;
+    QString m_traceDir;
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,14 @@
+# Benchmarks for the render engine; prints machine-readable JSON.
+#   qmake bench/gifstew-bench.pro && make && ./gifstew-bench --quick
+
+QT       = core gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = gifstew-bench
+
+include(../engine.pri)
+
+SOURCES += \
+    main.cpp
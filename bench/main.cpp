@@ -0,0 +1,329 @@
+#include "gifengine.h"
+#include "framepipeline.h"
+#include "texturesampler.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtMath>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <memory>
+
+// gifstew-bench: times the generators and their hot helpers over a matrix of
+// sizes, frame rates and modes, and prints one JSON document.
+//
+//   gifstew-bench                         full matrix (128..2048 px), JSON on stdout
+//   gifstew-bench --quick --out run.json  128/512 px at 12 fps only
+//   gifstew-bench --filter globe          cases whose name contains "globe"
+//
+// Test images are synthesized in-process (no files or network needed). The
+// generators still read their source from disk, so those are written to a
+// temporary folder first.
+//
+// Each case is run once to warm up, then repeated until --min-time has
+// passed. min/median/mean are per call in nanoseconds; cases that produce
+// frames also report them, so ns_per_frame compares across fps and modes.
+
+namespace {
+
+struct Sample {
+    QString     name;
+    QJsonObject params;
+    std::function<int()> op;             // returns frames produced, or -1 on failure
+};
+
+// --- Helper: synthetic source image. A shaded disc with stripes and a
+//     coloured ring on a transparent (or flat grey) border, so cropping,
+//     palette building and the optimizer all have real work to do.
+static QImage makeTestImage(int w, int h, bool alpha, int seed = 0)
+{
+    QImage img(w, h, QImage::Format_ARGB32);
+    const double cx = w * 0.5, cy = h * 0.5;
+    const double r = qMin(w, h) * 0.42;
+    for (int y = 0; y < h; ++y) {
+        QRgb *row = reinterpret_cast<QRgb *>(img.scanLine(y));
+        for (int x = 0; x < w; ++x) {
+            const double dx = x - cx, dy = y - cy;
+            const double d = std::sqrt(dx * dx + dy * dy) / r;
+            if (d > 1.0) {
+                row[x] = alpha ? qRgba(0, 0, 0, 0) : qRgb(128, 128, 128);
+                continue;
+            }
+            const int stripe = ((x + y + seed * 7) / qMax(1, w / 32)) & 1;
+            const int red    = int(255 * (1.0 - d));
+            const int green  = stripe ? 200 : int(120 * d);
+            const int blue   = (d > 0.8) ? 255 : (x * 255 / qMax(1, w - 1) + seed * 40) & 255;
+            const int a      = alpha ? int(255 * qMin(1.0, (1.0 - d) * 8.0)) : 255;
+            row[x] = qRgba(red, green, blue, a);
+        }
+    }
+    return img;
+}
+
+// --- Helper: run 'op' until minTimeMs has passed (after one warm-up call)
+static QJsonObject measure(const Sample &s, qint64 minTimeMs)
+{
+    QJsonObject r = s.params;
+    r.insert("name", s.name);
+
+    const int warm = s.op();
+    if (warm < 0) {
+        r.insert("error", QStringLiteral("failed"));
+        return r;
+    }
+
+    QVector<qint64> ns;
+    QElapsedTimer total;
+    total.start();
+    do {
+        QElapsedTimer t;
+        t.start();
+        s.op();
+        ns.append(t.nsecsElapsed());
+    } while (total.elapsed() < minTimeMs && ns.size() < 10000);
+
+    std::sort(ns.begin(), ns.end());
+    qint64 sum = 0;
+    for (qint64 v : ns) sum += v;
+    const double mean = double(sum) / ns.size();
+
+    r.insert("reps", ns.size());
+    r.insert("min_ns", double(ns.first()));
+    r.insert("median_ns", double(ns[ns.size() / 2]));
+    r.insert("mean_ns", mean);
+    if (warm > 0) {
+        r.insert("frames", warm);
+        r.insert("ns_per_frame", double(ns[ns.size() / 2]) / warm);
+    }
+    return r;
+}
+
+static QList<int> intList(const QString &csv)
+{
+    QList<int> out;
+    for (const QString &part : csv.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int v = part.trimmed().toInt(&ok);
+        if (ok && v > 0) out << v;
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gifstew-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark the GIFStew generators and helpers; prints JSON.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"sizes", "Comma-separated output sizes in px. Default: 128,256,512,1024,2048.", "list",
+         "128,256,512,1024,2048"},
+        {"fps", "Comma-separated frame rates for the generator cases. Default: 12,24.", "list", "12,24"},
+        {"quick", "Small matrix: 128,512 px at 12 fps."},
+        {"filter", "Only run cases whose name contains this text.", "text"},
+        {"min-time", "Minimum measuring time per case, ms. Default: 300.", "ms", "300"},
+        {"threads", "Render threads for the generator cases. Default: all cores.", "n"},
+        {"out", "Write the JSON here instead of stdout.", "path"},
+    });
+    parser.process(app);
+
+    QList<int> sizes = intList(parser.value("sizes"));
+    QList<int> fpsList = intList(parser.value("fps"));
+    if (parser.isSet("quick")) {
+        sizes   = { 128, 512 };
+        fpsList = { 12 };
+    }
+    const QString filter   = parser.value("filter");
+    const qint64  minTime  = qMax(1, parser.value("min-time").toInt());
+    const int     threads  = parser.isSet("threads") ? qMax(1, parser.value("threads").toInt())
+                                                     : qMax(1, QThread::idealThreadCount());
+
+    // Fixed engine knobs, so runs compare regardless of the saved settings
+    GifEngine::Options opts;
+    opts.renderThreads  = threads;
+    opts.paletteMode    = FramePipeline::GlobalPalette;
+    opts.optimizeFrames = true;
+    opts.backsideMode   = GifEngine::BacksideOff;
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid()) {
+        std::fprintf(stderr, "gifstew-bench: cannot create a temp folder\n");
+        return 1;
+    }
+    const QString frontPath = QDir(tmp.path()).filePath("front.png");
+    const QString backPath  = QDir(tmp.path()).filePath("back.png");
+    const QString outPath   = QDir(tmp.path()).filePath("out.gif");
+    makeTestImage(1024, 1024, true, 0).save(frontPath, "PNG");
+    makeTestImage(1024, 1024, true, 1).save(backPath, "PNG");
+    opts.backImagePath = backPath;
+
+    QList<Sample> cases;
+    auto add = [&](const QString &name, const QJsonObject &params, const std::function<int()> &op) {
+        if (!filter.isEmpty() && !name.contains(filter, Qt::CaseInsensitive)) return;
+        Sample s;
+        s.name   = name;
+        s.params = params;
+        s.op     = op;
+        cases << s;
+    };
+
+    // --- Hot helpers, one call each
+    for (int size : sizes) {
+        const QJsonObject p { { "size", size } };
+        const QImage alphaSrc  = makeTestImage(size, size, true);
+        const QImage opaqueSrc = makeTestImage(size, size, false);
+        const QImage wideSrc   = makeTestImage(size * 3 / 2, size, true);
+
+        add("makeSquareCanvas", p, [=] {
+            return GifEngine::makeSquareCanvas(wideSrc, size, Qt::transparent).isNull() ? -1 : 0;
+        });
+        add("cropToContentSmart", QJsonObject { { "size", size }, { "alpha", true } }, [=] {
+            return GifEngine::cropToContentSmart(alphaSrc).isNull() ? -1 : 0;
+        });
+        add("cropToContentSmart", QJsonObject { { "size", size }, { "alpha", false } }, [=] {
+            return GifEngine::cropToContentSmart(opaqueSrc).isNull() ? -1 : 0;
+        });
+        add("makeBacksideFrom", p, [=] {
+            bool ok = false;
+            GifEngine::makeBacksideFrom(alphaSrc, &ok, nullptr);
+            return ok ? 0 : -1;
+        });
+        add("zoomImage", p, [=] {
+            return GifEngine::zoomImage(alphaSrc, 150.0, Qt::transparent).isNull() ? -1 : 0;
+        });
+
+        // Globe textures are 2:1 equirectangular
+        const QImage front = makeTestImage(size * 2, size, true, 0);
+        const QImage back  = makeTestImage(size * 2, size, true, 1);
+        const auto sampler = std::make_shared<TextureSampler>(front, back, QColor(Qt::darkBlue));
+        add("sampleTexture", p, [=] {
+            // One size x size frame's worth of rows across the whole sphere
+            QVector<quint32> lon(size), yF(size), yB(size);
+            QVector<QRgb> out(size);
+            for (int y = 0; y < size; ++y) {
+                const qreal lat = (y + 0.5) / size * M_PI - M_PI_2;
+                const quint32 rf = TextureSampler::rowFor(lat, sampler->frontHeight());
+                const quint32 rb = TextureSampler::rowFor(lat, sampler->backHeight());
+                for (int x = 0; x < size; ++x) {
+                    lon[x] = quint32(quint64(x) * 0x100000000ull / size);
+                    yF[x] = rf;
+                    yB[x] = rb;
+                }
+                sampler->sampleRow(lon.constData(), yF.constData(), yB.constData(), out.data(), size);
+            }
+            return 0;
+        });
+        add("renderGlobeFrame", p, [=] {
+            GifEngine engine(opts);
+            return engine.renderGlobeFrame(*sampler, 37.0, size, Qt::transparent, true, 0).isNull() ? -1 : 0;
+        });
+    }
+
+    // --- Generators, render only (frames go to a sink) and end to end (GIF written)
+    struct Mode { const char *name; bool spin, yaw, flip, osc, globe; };
+    const Mode modes[] = {
+        { "spin",          true,  false, false, false, false },
+        { "yaw",           false, true,  false, false, false },
+        { "flip",          false, false, true,  false, false },
+        { "spin+yaw+flip", true,  true,  true,  false, false },
+        { "oscillate",     false, false, false, true,  false },
+        { "globe",         false, false, false, false, true  },
+    };
+    for (int size : sizes) {
+        for (int fps : fpsList) {
+            for (const Mode &m : modes) {
+                for (bool encode : { false, true }) {
+                    const QJsonObject p { { "size", size }, { "fps", fps }, { "mode", m.name },
+                                          { "threads", threads } };
+                    add(encode ? "generateGif" : "generateFrames", p, [=] {
+                        GifEngine engine(opts);
+                        int sunk = 0;
+                        if (!encode) engine.setFrameSink([&sunk](const QImage &) { ++sunk; });
+                        QString err;
+                        bool ok;
+                        if (m.globe)
+                            ok = engine.generateGlobeGif(frontPath, backPath, outPath, fps, 1, size,
+                                                         1.0, 100.0, 0, Qt::transparent, &err);
+                        else if (m.osc)
+                            ok = engine.generateOscillateGif(frontPath, outPath, fps, 1, size, 15.0,
+                                                             Qt::transparent, &err);
+                        else
+                            ok = engine.generateCompositeGif(frontPath, outPath, fps, 1, size,
+                                                             m.spin, 360.0, m.yaw, 1.0,
+                                                             m.flip, m.flip, 1, Qt::transparent, &err);
+                        if (!ok) return -1;
+                        return encode ? engine.lastFrameCount() : sunk;
+                    });
+                }
+            }
+
+            // --- Encode step alone: quantize + optimize + LZW of pre-rendered
+            //     spin frames (rendered by the warm-up call, freed after the case)
+            const QJsonObject p { { "size", size }, { "fps", fps } };
+            auto frames = std::make_shared<QList<QImage>>();
+            add("encode", p, [=] {
+                if (frames->isEmpty()) {
+                    GifEngine engine(opts);
+                    engine.setFrameSink([frames](const QImage &f) { frames->append(f); });
+                    QString err;
+                    engine.generateCompositeGif(frontPath, outPath, fps, 1, size,
+                                                true, 360.0, false, 1.0, false, false, 1,
+                                                Qt::transparent, &err);
+                }
+                FramePipeline pipeline;
+                pipeline.setWorkerCount(threads);
+                pipeline.setPaletteMode(FramePipeline::GlobalPalette);
+                pipeline.setOptimizeFrames(true);
+                QString err;
+                if (frames->isEmpty() || !pipeline.start(outPath, frames->first().size(), fps, &err)) return -1;
+                pipeline.renderFrames(frames->size(), [&](int i) { return frames->at(i); });
+                return pipeline.finish(&err) ? int(frames->size()) : -1;
+            });
+        }
+    }
+
+    // --- Run
+    QJsonArray results;
+    for (int i = 0; i < cases.size(); ++i) {
+        const Sample s = cases[i];
+        std::fprintf(stderr, "[%d/%d] %s %s\n", i + 1, int(cases.size()), qPrintable(s.name),
+                     QJsonDocument(s.params).toJson(QJsonDocument::Compact).constData());
+        results.append(measure(s, minTime));
+        cases[i].op = nullptr;   // drops anything the case cached
+    }
+
+    QJsonObject doc;
+    doc.insert("benchmark", QStringLiteral("gifstew"));
+    doc.insert("date", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    doc.insert("qt", QString::fromLatin1(qVersion()));
+    doc.insert("cpuThreads", QThread::idealThreadCount());
+    doc.insert("minTimeMs", double(minTime));
+    doc.insert("results", results);
+    const QByteArray json = QJsonDocument(doc).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet("out")) {
+        QFile f(parser.value("out"));
+        if (!f.open(QIODevice::WriteOnly) || f.write(json) != json.size()) {
+            std::fprintf(stderr, "gifstew-bench: cannot write %s\n", qPrintable(parser.value("out")));
+            return 1;
+        }
+    } else {
+        std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+    }
+    return 0;
+}
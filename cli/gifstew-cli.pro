@@ -0,0 +1,19 @@
+# Headless front end: same render engine as the GUI, no QtWidgets and no display.
+#   qmake cli/gifstew-cli.pro && make
+
+QT       = core gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = gifstew-cli
+
+include(../engine.pri)
+
+SOURCES += \
+    main.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
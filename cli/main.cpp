@@ -0,0 +1,225 @@
+#include "gifengine.h"
+#include "batchrunner.h"
+#include "runprofile.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QFileInfo>
+#include <QStringList>
+#include <cstdio>
+
+// gifstew-cli: every GUI parameter as a flag, one GIF per invocation.
+//
+//   gifstew-cli -i logo.png -o logo.gif --mode spin,yaw --fps 30 --duration 2
+//   gifstew-cli -i earth.png -o earth.gif --mode globe --globe-axis both
+//   gifstew-cli --batch catalog.json --threads 16 --report reports/
+//   gifstew-cli -i earth.png -o earth.gif --mode globe --trace earth.trace.json
+//   gifstew-cli -i logo.png -o logo.gif --size 512 --sizes 128,256
+//
+// Exit code 0 on success, 1 on a generation error (any job, in batch mode),
+// 2 on bad arguments. Errors go to stderr (and, with --verbose, engine
+// diagnostics); stdout only gets the batch throughput summary.
+
+namespace {
+
+// --- Helper: print to stderr
+static void printErr(const QString &msg)
+{
+    std::fprintf(stderr, "gifstew-cli: %s\n", qPrintable(msg));
+}
+
+// --- Helper: "transparent" | "black" | "white" | any QColor name (#rrggbb, ...)
+static bool parseColor(const QString &text, QColor *out)
+{
+    if (text.compare("transparent", Qt::CaseInsensitive) == 0) { *out = Qt::transparent; return true; }
+    const QColor c(text);
+    if (!c.isValid()) return false;
+    *out = c;
+    return true;
+}
+
+// --- Helper: option value as int/double, with range check
+static bool intValue(const QCommandLineParser &p, const QString &name, int lo, int hi, int *out)
+{
+    bool ok = false;
+    const int v = p.value(name).toInt(&ok);
+    if (!ok || v < lo || v > hi) {
+        printErr(QStringLiteral("--%1 must be an integer in [%2, %3]").arg(name).arg(lo).arg(hi));
+        return false;
+    }
+    *out = v;
+    return true;
+}
+
+static bool realValue(const QCommandLineParser &p, const QString &name, double lo, double hi, double *out)
+{
+    bool ok = false;
+    const double v = p.value(name).toDouble(&ok);
+    if (!ok || v < lo || v > hi) {
+        printErr(QStringLiteral("--%1 must be a number in [%2, %3]").arg(name).arg(lo).arg(hi));
+        return false;
+    }
+    *out = v;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // QCoreApplication: no platform plugin, no display; QImage/QPainter on
+    // images work without a GUI application.
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gifstew-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Render a GIFStew animation without the GUI.");
+    parser.addHelpOption();
+
+    parser.addOptions({
+        {{"i", "input"},  "Source image.", "path"},
+        {{"o", "output"}, "Output GIF.", "path"},
+        {{"m", "mode"},
+         "Comma-separated spin,yaw,flip (combined like the GUI), or oscillate, or globe. Default: spin.",
+         "modes", "spin"},
+        {"back", "Explicit back-face image (yaw/flip/globe).", "path"},
+        {"backside", "Simulate the back face when --back is not given: off, normal, upside-down. Default: saved setting.", "mode"},
+        {"crop", "Trim transparent/flat borders before padding to a square."},
+        {"fps", "Frames per second. Default: 24.", "n", "24"},
+        {"duration", "Seconds per revolution (fractional allowed). Default: 1.", "sec", "1"},
+        {"size", "Output size in pixels (square), 32-4096 (globe: 64-4096). Default: 512.", "px", "512"},
+        {"sizes", "More output sizes from the same render, e.g. 128,256; written as <output>_<px>.gif.", "px,..."},
+        {"bg", "Background: transparent, black, white or #rrggbb. Default: transparent.", "color", "transparent"},
+        {"yaw-rotations", "Yaw turns per loop. Default: 1.", "n", "1"},
+        {"flip-cycles", "Flips per loop. Default: 1.", "n", "1"},
+        {"max-degrees", "Oscillate amplitude in degrees. Default: 15.", "deg", "15"},
+        {"globe-rotations", "Globe turns per loop. Default: 1.", "n", "1"},
+        {"globe-zoom", "Globe texture zoom in percent. Default: 100.", "pct", "100"},
+        {"globe-axis", "Globe rotation axis: horizontal, vertical, both. Default: horizontal.", "axis", "horizontal"},
+        {"threads", "Render threads. Default: saved setting.", "n"},
+        {"palette", "Palette mode: global or per-frame. Default: saved setting.", "mode"},
+        {"no-optimize", "Write full frames instead of changed rectangles."},
+        {"batch", "Render every job in a JSON/CSV manifest instead of --input/--output.", "manifest"},
+        {"jobs", "Batch jobs rendering at once. Default: half the render threads.", "n"},
+        {"report", "Write a per-stage timing report: a JSON file, or with --batch a folder (one file per job).", "path"},
+        {"trace", "Write a render timeline for chrome://tracing / Perfetto: a JSON file, or with --batch a folder.", "path"},
+        {"verbose", "Log diagnostics, the output path and per-stage timing."},
+    });
+
+    parser.process(app);
+
+    // --- Engine options (shared by every job)
+    GifEngine::Options opts;
+    if (parser.isSet("backside")) {
+        const QString b = parser.value("backside").toLower();
+        if      (b == "off")         opts.backsideMode = GifEngine::BacksideOff;
+        else if (b == "normal")      opts.backsideMode = GifEngine::BacksideNormal;
+        else if (b == "upside-down") opts.backsideMode = GifEngine::BacksideUpsideDown;
+        else { printErr("--backside must be off, normal or upside-down"); return 2; }
+    }
+    if (parser.isSet("threads") && !intValue(parser, "threads", 1, 256, &opts.renderThreads)) return 2;
+    if (parser.isSet("palette")) {
+        const QString p = parser.value("palette").toLower();
+        if      (p == "global")    opts.paletteMode = FramePipeline::GlobalPalette;
+        else if (p == "per-frame") opts.paletteMode = FramePipeline::PerFramePalette;
+        else { printErr("--palette must be global or per-frame"); return 2; }
+    }
+    if (parser.isSet("no-optimize")) opts.optimizeFrames = false;
+    if (parser.isSet("sizes")) {
+        bool ok = false;
+        opts.outputSizes = GifEngine::parseSizeList(parser.value("sizes"), &ok);
+        if (!ok) { printErr("--sizes must be pixel sizes in [16, 4096], e.g. 128,256"); return 2; }
+    }
+
+    const bool verbose = parser.isSet("verbose");
+    auto logger = [verbose](const QString &msg) { if (verbose) printErr(msg); };
+
+    // --- Batch: every job from the manifest, on one shared render pool
+    if (parser.isSet("batch")) {
+        QVector<BatchRunner::Job> jobs;
+        QString err;
+        if (!BatchRunner::loadManifest(parser.value("batch"), &jobs, &err)) { printErr(err); return 2; }
+
+        BatchRunner runner;
+        runner.setBaseOptions(opts);
+        runner.setLogger(logger);
+        int concurrent = 0;
+        if (parser.isSet("jobs") && !intValue(parser, "jobs", 1, 256, &concurrent)) return 2;
+        runner.setConcurrentJobs(concurrent);
+        runner.setReportDir(parser.value("report"));
+        runner.setTraceDir(parser.value("trace"));
+        runner.setJobFinished([&jobs, verbose](int index, const BatchRunner::Result &r) {
+            if (!r.ok)
+                printErr(QStringLiteral("job %1 (%2) failed: %3").arg(index + 1).arg(jobs[index].output, r.error));
+            else if (verbose)
+                printErr(QStringLiteral("job %1: wrote %2 (%3 frames, %4 s)")
+                             .arg(index + 1).arg(jobs[index].output).arg(r.frames).arg(r.seconds, 0, 'f', 2));
+            if (verbose) printErr(QStringLiteral("job %1: %2").arg(index + 1).arg(r.timing));
+        });
+
+        const BatchRunner::Stats st = runner.run(jobs);
+        std::printf("%d jobs (%d failed), %lld frames in %.2f s: %.2f jobs/s, %.1f frames/s\n",
+                    st.jobs, st.failed, static_cast<long long>(st.frames), st.seconds,
+                    st.jobsPerSec(), st.framesPerSec());
+        return st.failed ? 1 : 0;
+    }
+
+    // --- Single job from the flags
+    BatchRunner::Job job;
+    job.source = parser.value("input");
+    job.output = parser.value("output");
+    job.back   = parser.value("back");
+    job.crop   = parser.isSet("crop");
+    if (job.source.isEmpty() || !QFileInfo::exists(job.source)) { printErr("missing or unreadable --input"); return 2; }
+    if (job.output.isEmpty())                                   { printErr("missing --output");               return 2; }
+
+    QString modeErr;
+    if (!job.setMode(parser.value("mode"), &modeErr)) { printErr(modeErr); return 2; }
+
+    // Same ranges as the GUI spin boxes' intent
+    if (!intValue(parser, "fps", 1, 100, &job.fps)) return 2;
+    if (!intValue(parser, "size", job.minSize(), 4096, &job.size)) return 2;
+    if (!intValue(parser, "flip-cycles", 1, 1000, &job.flipCycles)) return 2;
+    if (!realValue(parser, "duration", 0.10, 3600.0, &job.duration)) return 2;
+    if (!realValue(parser, "yaw-rotations", 0.0, 1000.0, &job.yawRotations)) return 2;
+    if (!realValue(parser, "max-degrees", 0.0, 360.0, &job.maxDegrees)) return 2;
+    if (!realValue(parser, "globe-rotations", 0.0, 1000.0, &job.globeRotations)) return 2;
+    if (!realValue(parser, "globe-zoom", 1.0, 1000.0, &job.globeZoom)) return 2;
+
+    if (!parseColor(parser.value("bg"), &job.bg)) { printErr("invalid --bg color"); return 2; }
+
+    const QString axisText = parser.value("globe-axis").toLower();
+    if      (axisText == "horizontal") job.globeAxis = 0;
+    else if (axisText == "vertical")   job.globeAxis = 1;
+    else if (axisText == "both")       job.globeAxis = 2;
+    else { printErr("--globe-axis must be horizontal, vertical or both"); return 2; }
+
+    GifEngine engine(opts);
+    engine.setLogger(logger);
+    RunProfile profile;
+    profile.setTracing(parser.isSet("trace"));
+    engine.setProfile(&profile);
+
+    BatchRunner::Result result;
+    result.ok      = BatchRunner::runJob(engine, job, &result.error);
+    result.frames  = engine.lastFrameCount();
+    profile.stop();
+    result.seconds = profile.wallNs() / 1e9;
+
+    if (verbose) printErr(profile.summary());
+    if (parser.isSet("report")) {
+        QString reportErr;
+        if (!profile.writeJson(parser.value("report"), BatchRunner::describe(job, result), &reportErr))
+            printErr(reportErr);
+    }
+    if (parser.isSet("trace")) {
+        QString traceErr;
+        if (!profile.writeTrace(parser.value("trace"), &traceErr)) printErr(traceErr);
+    }
+    if (!result.ok) {
+        printErr(result.error.isEmpty() ? QStringLiteral("generation failed") : result.error);
+        return 1;
+    }
+    if (verbose) printErr(QStringLiteral("wrote %1").arg(job.output));
+    return 0;
+}
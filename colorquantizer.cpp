@@ -0,0 +1,321 @@
+#include "colorquantizer.h"
+#include <QSet>
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+constexpr int kGridBits  = 5;
+constexpr int kGridSize  = 1 << kGridBits;
+constexpr int kGridCells = kGridSize * kGridSize * kGridSize;
+
+static inline int cellOf(QRgb c)
+{
+    return ((qRed(c) >> 3) << (2 * kGridBits)) | ((qGreen(c) >> 3) << kGridBits) | (qBlue(c) >> 3);
+}
+
+// One occupied histogram cell, as seen by median cut
+struct CutEntry {
+    int     c[3];       // cell coordinates (0..31)
+    quint32 count;
+    quint64 sum[3];     // sums of the real 8-bit channel values
+};
+
+struct CutBox {
+    int     begin, end; // range in the entry array
+    quint64 population;
+    int     lo[3], hi[3];
+};
+
+static void shrinkBox(CutBox &box, const QVector<CutEntry> &entries)
+{
+    box.population = 0;
+    for (int a = 0; a < 3; ++a) { box.lo[a] = kGridSize; box.hi[a] = -1; }
+    for (int i = box.begin; i < box.end; ++i) {
+        const CutEntry &e = entries[i];
+        box.population += e.count;
+        for (int a = 0; a < 3; ++a) {
+            box.lo[a] = qMin(box.lo[a], e.c[a]);
+            box.hi[a] = qMax(box.hi[a], e.c[a]);
+        }
+    }
+}
+
+static int longestAxis(const CutBox &box)
+{
+    int axis = 0;
+    for (int a = 1; a < 3; ++a)
+        if (box.hi[a] - box.lo[a] > box.hi[axis] - box.lo[axis]) axis = a;
+    return axis;
+}
+
+} // namespace
+
+// 5-bit-per-channel histogram plus the exact colour set while it stays small
+struct ColorQuantizer::Histogram
+{
+    QVector<quint32> count = QVector<quint32>(kGridCells, 0);
+    QVector<quint64> sum[3] = { QVector<quint64>(kGridCells, 0),
+                                QVector<quint64>(kGridCells, 0),
+                                QVector<quint64>(kGridCells, 0) };
+    QHash<QRgb, int> exact;
+    int  exactLimit = 255;
+    bool tooMany = false;
+};
+
+ColorQuantizer::ColorQuantizer(const QVector<QRgb> &palette)
+    : m_palette(palette)
+{
+    buildGrid(nullptr);
+}
+
+void ColorQuantizer::accumulate(Histogram &hist, const QImage &src)
+{
+    const QImage img = src.convertToFormat(QImage::Format_ARGB32);
+    QRgb last = 0;
+    bool haveLast = false;
+
+    for (int y = 0; y < img.height(); ++y) {
+        const QRgb *row = reinterpret_cast<const QRgb *>(img.constScanLine(y));
+        for (int x = 0; x < img.width(); ++x) {
+            if (qAlpha(row[x]) < 128) continue;
+            const QRgb c = row[x] | 0xFF000000u;
+            const int cell = cellOf(c);
+            ++hist.count[cell];
+            hist.sum[0][cell] += quint64(qRed(c));
+            hist.sum[1][cell] += quint64(qGreen(c));
+            hist.sum[2][cell] += quint64(qBlue(c));
+
+            // Runs of the same colour are common; only hash colour changes
+            if (hist.tooMany || (haveLast && c == last)) continue;
+            last = c;
+            haveLast = true;
+            if (!hist.exact.contains(c)) {
+                if (hist.exact.size() >= hist.exactLimit) { hist.tooMany = true; hist.exact.clear(); }
+                else hist.exact.insert(c, hist.exact.size());
+            }
+        }
+    }
+}
+
+QVector<QRgb> ColorQuantizer::medianCut(const Histogram &hist, int maxColors)
+{
+    // Few enough distinct colours: keep them all
+    if (!hist.tooMany) {
+        QVector<QRgb> exact(hist.exact.size());
+        for (auto it = hist.exact.constBegin(); it != hist.exact.constEnd(); ++it)
+            exact[it.value()] = it.key();
+        return exact;
+    }
+
+    QVector<CutEntry> entries;
+    for (int cell = 0; cell < kGridCells; ++cell) {
+        if (!hist.count[cell]) continue;
+        CutEntry e;
+        e.c[0] = cell >> (2 * kGridBits);
+        e.c[1] = (cell >> kGridBits) & (kGridSize - 1);
+        e.c[2] = cell & (kGridSize - 1);
+        e.count = hist.count[cell];
+        for (int a = 0; a < 3; ++a) e.sum[a] = hist.sum[a][cell];
+        entries.append(e);
+    }
+    if (entries.isEmpty()) return QVector<QRgb>();
+
+    QVector<CutBox> boxes;
+    CutBox all;
+    all.begin = 0;
+    all.end = entries.size();
+    shrinkBox(all, entries);
+    boxes.append(all);
+
+    while (boxes.size() < maxColors) {
+        // Split the box with the largest population x extent
+        int pick = -1;
+        quint64 bestScore = 0;
+        for (int i = 0; i < boxes.size(); ++i) {
+            const CutBox &b = boxes[i];
+            if (b.end - b.begin < 2) continue;
+            const int axis = longestAxis(b);
+            const quint64 score = b.population * quint64(b.hi[axis] - b.lo[axis] + 1);
+            if (score > bestScore) { bestScore = score; pick = i; }
+        }
+        if (pick < 0) break;   // every box is a single cell
+
+        CutBox box = boxes[pick];
+        const int axis = longestAxis(box);
+        std::sort(entries.begin() + box.begin, entries.begin() + box.end,
+                  [axis](const CutEntry &a, const CutEntry &b) { return a.c[axis] < b.c[axis]; });
+
+        // Split at the population median, leaving at least one entry per side
+        quint64 acc = 0;
+        int split = box.begin + 1;
+        for (int i = box.begin; i < box.end - 1; ++i) {
+            acc += entries[i].count;
+            split = i + 1;
+            if (acc * 2 >= box.population) break;
+        }
+
+        CutBox lower = box, upper = box;
+        lower.end = split;
+        upper.begin = split;
+        shrinkBox(lower, entries);
+        shrinkBox(upper, entries);
+        boxes[pick] = lower;
+        boxes.append(upper);
+    }
+
+    QVector<QRgb> palette;
+    palette.reserve(boxes.size());
+    for (const CutBox &b : boxes) {
+        quint64 sum[3] = { 0, 0, 0 };
+        for (int i = b.begin; i < b.end; ++i)
+            for (int a = 0; a < 3; ++a) sum[a] += entries[i].sum[a];
+        const quint64 n = qMax<quint64>(1, b.population);
+        palette.append(qRgb(int((sum[0] + n / 2) / n),
+                            int((sum[1] + n / 2) / n),
+                            int((sum[2] + n / 2) / n)));
+    }
+    return palette;
+}
+
+QVector<QRgb> ColorQuantizer::buildPalette(const QList<QImage> &images, int maxColors)
+{
+    maxColors = qBound(1, maxColors, 255);
+    Histogram hist;
+    hist.exactLimit = maxColors;
+    for (const QImage &img : images) accumulate(hist, img);
+    return medianCut(hist, maxColors);
+}
+
+QImage ColorQuantizer::quantize(const QImage &src, int maxColors)
+{
+    maxColors = qBound(1, maxColors, 255);
+    Histogram hist;
+    hist.exactLimit = maxColors;
+    accumulate(hist, src);
+
+    // Only the cells this frame actually uses need a grid entry
+    ColorQuantizer q;
+    q.m_palette = medianCut(hist, maxColors);
+    q.buildGrid(&hist.count);
+    return q.map(src);
+}
+
+bool ColorQuantizer::hasFewColors(const QImage &src, int maxColors)
+{
+    const QImage img = src.convertToFormat(QImage::Format_ARGB32);
+    QSet<QRgb> seen;
+    QRgb last = 0;
+    bool haveLast = false;
+
+    for (int y = 0; y < img.height(); ++y) {
+        const QRgb *row = reinterpret_cast<const QRgb *>(img.constScanLine(y));
+        for (int x = 0; x < img.width(); ++x) {
+            if (qAlpha(row[x]) < 128) continue;
+            const QRgb c = row[x] | 0xFF000000u;
+            if (haveLast && c == last) continue;
+            last = c;
+            haveLast = true;
+            seen.insert(c);
+            if (seen.size() > maxColors) return false;
+        }
+    }
+    return true;
+}
+
+int ColorQuantizer::nearest(int r, int g, int b) const
+{
+    int best = 0;
+    int bestDist = INT_MAX;
+    for (int i = 0; i < m_palette.size(); ++i) {
+        const QRgb p = m_palette[i];
+        const int dr = qRed(p) - r, dg = qGreen(p) - g, db = qBlue(p) - b;
+        const int d = dr*dr + dg*dg + db*db;
+        if (d < bestDist) { bestDist = d; best = i; if (d == 0) break; }
+    }
+    return best;
+}
+
+// Cells holding exactly one palette colour map to it. Cells holding several
+// are resolved per pixel against just those colours, so an exact palette
+// never loses a colour. Empty cells map to the entry nearest their centre.
+void ColorQuantizer::buildGrid(const QVector<quint32> *usedCells)
+{
+    m_grid.fill(0, kGridCells);
+    m_cellShared.fill(0, kGridCells);
+    m_sharedStart.clear();
+    m_shared.clear();
+    if (m_palette.isEmpty()) return;
+
+    QVector<int> owner(kGridCells, -1);
+    QHash<int, QVector<int>> shared;
+    for (int i = 0; i < m_palette.size(); ++i) {
+        const int cell = cellOf(m_palette[i]);
+        if (owner[cell] == -1) {
+            owner[cell] = i;
+        } else {
+            QVector<int> &list = shared[cell];
+            if (list.isEmpty()) list.append(owner[cell]);
+            list.append(i);
+        }
+    }
+
+    // Flattened so map() reads the candidates without touching the hash.
+    // Each shared cell holds two or more of <= 255 colours, so k fits a uchar.
+    m_sharedStart.append(0);
+    for (auto it = shared.constBegin(); it != shared.constEnd(); ++it) {
+        m_shared += it.value();
+        m_sharedStart.append(m_shared.size());
+        m_cellShared[it.key()] = uchar(m_sharedStart.size() - 1);
+    }
+
+    const int half = (256 / kGridSize) / 2;   // centre of a cell
+    for (int cell = 0; cell < kGridCells; ++cell) {
+        if (owner[cell] >= 0) { m_grid[cell] = uchar(owner[cell]); continue; }
+        if (usedCells && !(*usedCells)[cell]) continue;
+        const int r = ((cell >> (2 * kGridBits)) << 3) + half;
+        const int g = (((cell >> kGridBits) & (kGridSize - 1)) << 3) + half;
+        const int b = ((cell & (kGridSize - 1)) << 3) + half;
+        m_grid[cell] = uchar(nearest(r, g, b));
+    }
+}
+
+QImage ColorQuantizer::map(const QImage &src) const
+{
+    const QImage img = src.convertToFormat(QImage::Format_ARGB32);
+    const int w = img.width();
+    const int h = img.height();
+    const int transparentIndex = m_palette.size();
+
+    QImage out(w, h, QImage::Format_Indexed8);
+    QVector<QRgb> table = m_palette;
+    table.append(qRgba(0, 0, 0, 0));
+    out.setColorTable(table);
+
+    for (int y = 0; y < h; ++y) {
+        const QRgb *row = reinterpret_cast<const QRgb *>(img.constScanLine(y));
+        uchar *dst = out.scanLine(y);
+        for (int x = 0; x < w; ++x) {
+            const QRgb c = row[x];
+            if (qAlpha(c) < 128 || m_palette.isEmpty()) { dst[x] = uchar(transparentIndex); continue; }
+
+            const int cell = cellOf(c);
+            const int k = m_cellShared[cell];
+            if (!k) { dst[x] = m_grid[cell]; continue; }
+
+            // Several palette colours in this cell: pick the closest of them
+            const int *cand = m_shared.constData() + m_sharedStart[k - 1];
+            const int *candEnd = m_shared.constData() + m_sharedStart[k];
+            int best = *cand;
+            int bestDist = INT_MAX;
+            for (; cand != candEnd; ++cand) {
+                const QRgb p = m_palette[*cand];
+                const int dr = qRed(p) - qRed(c), dg = qGreen(p) - qGreen(c), db = qBlue(p) - qBlue(c);
+                const int d = dr*dr + dg*dg + db*db;
+                if (d < bestDist) { bestDist = d; best = *cand; }
+            }
+            dst[x] = uchar(best);
+        }
+    }
+    return out;
+}
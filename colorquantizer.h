@@ -0,0 +1,64 @@
+#ifndef COLORQUANTIZER_H
+#define COLORQUANTIZER_H
+
+#include <QImage>
+#include <QList>
+#include <QVector>
+#include <QHash>
+
+// Colour reduction for GIF output.
+//
+// Palettes come from median cut over a 5-bit-per-channel histogram, with each
+// palette entry set to the mean of the real colours in its box. If the source
+// has no more distinct colours than the palette allows, the palette is exact.
+//
+// Pixels map to the palette through a 32x32x32 lookup grid (the nearest entry
+// to each cell centre), so mapping a frame costs one table read per pixel.
+// Cells that contain more than one palette colour are resolved exactly, so an
+// exact palette stays lossless.
+//
+// Pixels with alpha < 128 always map to a transparent entry (alpha 0) at the
+// end of the table.
+//
+// A ColorQuantizer built from a palette is read-only after construction. One
+// instance can map frames on several threads at once. That is how one palette
+// gets shared across a whole animation.
+class ColorQuantizer
+{
+public:
+    ColorQuantizer() = default;
+    explicit ColorQuantizer(const QVector<QRgb> &palette);
+
+    // Median-cut palette of at most maxColors (<= 255) opaque colours for all
+    // the given images together.
+    static QVector<QRgb> buildPalette(const QList<QImage> &images, int maxColors = 255);
+
+    // One-off: palette built from 'src' alone, then applied to it.
+    static QImage quantize(const QImage &src, int maxColors = 255);
+
+    // True if 'src' has at most maxColors distinct opaque colours, i.e.
+    // quantize() would be lossless. Stops scanning as soon as it finds more.
+    static bool hasFewColors(const QImage &src, int maxColors = 255);
+
+    // Indexed8 copy of 'src' using this palette (plus the transparent entry).
+    QImage map(const QImage &src) const;
+
+    bool isNull() const { return m_palette.isEmpty(); }
+    const QVector<QRgb> &palette() const { return m_palette; }
+
+private:
+    struct Histogram;
+    static void accumulate(Histogram &hist, const QImage &img);
+    static QVector<QRgb> medianCut(const Histogram &hist, int maxColors);
+
+    void buildGrid(const QVector<quint32> *usedCells);
+    int  nearest(int r, int g, int b) const;
+
+    QVector<QRgb>  m_palette;      // opaque colours
+    QVector<uchar> m_grid;         // 32^3 cells -> palette index
+    QVector<uchar> m_cellShared;   // k > 0: several palette colours fall in this cell
+    QVector<int>   m_sharedStart;  // candidates of shared cell k: m_shared[start[k-1] .. start[k])
+    QVector<int>   m_shared;       // candidate palette indices, all shared cells back to back
+};
+
+#endif // COLORQUANTIZER_H
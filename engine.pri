@@ -0,0 +1,34 @@
+# Render engine shared by the GUI (GIFStew.pro) and the headless CLI
+# (cli/gifstew-cli.pro). Widget-free: QtCore + QtGui only.
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/affinewarp.cpp \
+    $$PWD/batchrunner.cpp \
+    $$PWD/colorquantizer.cpp \
+    $$PWD/frameoptimizer.cpp \
+    $$PWD/framepool.cpp \
+    $$PWD/framepipeline.cpp \
+    $$PWD/gifencoder.cpp \
+    $$PWD/gifengine.cpp \
+    $$PWD/globescroll.cpp \
+    $$PWD/runprofile.cpp \
+    $$PWD/sourcecache.cpp \
+    $$PWD/sphereprojection.cpp \
+    $$PWD/texturesampler.cpp
+
+HEADERS += \
+    $$PWD/affinewarp.h \
+    $$PWD/batchrunner.h \
+    $$PWD/colorquantizer.h \
+    $$PWD/frameoptimizer.h \
+    $$PWD/framepool.h \
+    $$PWD/framepipeline.h \
+    $$PWD/gifencoder.h \
+    $$PWD/gifengine.h \
+    $$PWD/globescroll.h \
+    $$PWD/runprofile.h \
+    $$PWD/sourcecache.h \
+    $$PWD/sphereprojection.h \
+    $$PWD/texturesampler.h
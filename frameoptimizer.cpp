@@ -0,0 +1,227 @@
+#include "frameoptimizer.h"
+#include "gifencoder.h"
+#include <QVector>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// --- Helper: canvas pixels are either 0 (transparent) or opaque ARGB
+static QImage expandToCanvas(const QImage &indexed)
+{
+    QVector<QRgb> lut = indexed.colorTable();
+    for (QRgb &c : lut) c = (qAlpha(c) == 0) ? 0u : (c | 0xFF000000u);
+    lut.resize(256);
+
+    QImage shown(indexed.size(), QImage::Format_ARGB32);
+    for (int y = 0; y < indexed.height(); ++y) {
+        const uchar *src = indexed.constScanLine(y);
+        QRgb *dst = reinterpret_cast<QRgb *>(shown.scanLine(y));
+        for (int x = 0; x < indexed.width(); ++x) dst[x] = lut[src[x]];
+    }
+    return shown;
+}
+
+// --- Helper: first/last x where a[x] != b[x]; first = -1 if the rows match
+static void diffSpan(const QRgb *a, const QRgb *b, int n, int *first, int *last)
+{
+    int lo = 0;
+    int hi = n - 1;
+#if defined(__SSE2__)
+    // Narrow in from both ends 4 pixels at a time
+    while (lo + 4 <= n) {
+        const __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + lo)),
+                                           _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + lo)));
+        if (_mm_movemask_epi8(eq) != 0xFFFF) break;
+        lo += 4;
+    }
+#endif
+    while (lo < n && a[lo] == b[lo]) ++lo;
+    if (lo == n) { *first = *last = -1; return; }
+
+#if defined(__SSE2__)
+    while (hi - 3 > lo) {
+        const __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + hi - 3)),
+                                           _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + hi - 3)));
+        if (_mm_movemask_epi8(eq) != 0xFFFF) break;
+        hi -= 4;
+    }
+#endif
+    while (hi > lo && a[hi] == b[hi]) --hi;
+    *first = lo;
+    *last  = hi;
+}
+
+// --- Helper: first/last x where 'next' is transparent but 'shown' is not
+//     (pixels that can only be cleared by disposing to background)
+static void clearSpan(const QRgb *next, const QRgb *shown, int n, int *first, int *last)
+{
+    *first = *last = -1;
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 4 <= n; x += 4) {
+        const __m128i nz = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(next + x)), zero);
+        const __m128i sz = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(shown + x)), zero);
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_andnot_si128(sz, nz)));
+        if (!mask) continue;
+        for (int k = 0; k < 4; ++k) {
+            if (!(mask & (1 << k))) continue;
+            if (*first < 0) *first = x + k;
+            *last = x + k;
+        }
+    }
+#endif
+    for (; x < n; ++x) {
+        if (next[x] == 0 && shown[x] != 0) {
+            if (*first < 0) *first = x;
+            *last = x;
+        }
+    }
+}
+
+static QRect changedRect(const QImage &a, const QImage &b)
+{
+    QRect r;
+    for (int y = 0; y < a.height(); ++y) {
+        int first, last;
+        diffSpan(reinterpret_cast<const QRgb *>(a.constScanLine(y)),
+                 reinterpret_cast<const QRgb *>(b.constScanLine(y)), a.width(), &first, &last);
+        if (first >= 0) r |= QRect(first, y, last - first + 1, 1);
+    }
+    return r;
+}
+
+static QRect clearedRect(const QImage &next, const QImage &shown)
+{
+    QRect r;
+    for (int y = 0; y < next.height(); ++y) {
+        int first, last;
+        clearSpan(reinterpret_cast<const QRgb *>(next.constScanLine(y)),
+                  reinterpret_cast<const QRgb *>(shown.constScanLine(y)), next.width(), &first, &last);
+        if (first >= 0) r |= QRect(first, y, last - first + 1, 1);
+    }
+    return r;
+}
+
+} // namespace
+
+FrameOptimizer::FrameOptimizer(GifEncoder *encoder)
+    : m_encoder(encoder)
+{
+}
+
+bool FrameOptimizer::addFrame(const QImage &frame, int delayCs, QString *errOut)
+{
+    const QImage indexed = (frame.format() == QImage::Format_Indexed8) ? frame : GifEncoder::quantize(frame);
+
+    // Not a full-canvas frame: nothing to diff against, write it as is
+    if (indexed.size() != m_encoder->canvasSize()) {
+        if (!flush(errOut)) return false;
+        m_base = QImage();
+        return m_encoder->addFrame(indexed, QPoint(0, 0), delayCs, GifEncoder::DisposeBackground, errOut);
+    }
+
+    if (m_base.isNull()) {
+        m_base = QImage(indexed.size(), QImage::Format_ARGB32);
+        m_base.fill(0);
+    }
+
+    // The same frame again (e.g. a reused pose): show the pending one longer
+    if (m_hasPending && indexed.cacheKey() == m_pending.cacheKey() && extendPending(delayCs))
+        return true;
+
+    const QImage shown = expandToCanvas(indexed);
+    if (m_hasPending) {
+        // Renders that differ by less than the palette can show look the same
+        if (changedRect(m_pendingShown, shown).isEmpty() && extendPending(delayCs)) return true;
+        if (!emitPending(&shown, errOut)) return false;
+    }
+
+    m_pending      = indexed;
+    m_pendingShown = shown;
+    m_pendingRect  = changedRect(m_base, shown);
+    m_pendingDelay = delayCs;
+    m_hasPending   = true;
+    return true;
+}
+
+// Merges a frame identical to the pending one into it; false when the
+// combined delay no longer fits the GIF's 16-bit field
+bool FrameOptimizer::extendPending(int delayCs)
+{
+    if (m_pendingDelay + delayCs > 0xFFFF) return false;
+    m_pendingDelay += delayCs;
+    return true;
+}
+
+bool FrameOptimizer::flush(QString *errOut)
+{
+    if (!m_hasPending) return true;
+    return emitPending(nullptr, errOut);
+}
+
+bool FrameOptimizer::emitPending(const QImage *nextShown, QString *errOut)
+{
+    const QRect canvas(QPoint(0, 0), m_pendingShown.size());
+    QRect rect = m_pendingRect;
+    GifEncoder::Disposal disposal = GifEncoder::DisposeNone;
+
+    if (!nextShown) {
+        // Last frame: clear everything so the loop starts from an empty canvas
+        rect = canvas;
+        disposal = GifEncoder::DisposeBackground;
+    } else {
+        const QRect mustClear = clearedRect(*nextShown, m_pendingShown);
+        if (!mustClear.isEmpty()) {
+            rect |= mustClear;
+            disposal = GifEncoder::DisposeBackground;
+        }
+    }
+
+    // Nothing changed: GIF still needs an image, a single kept pixel will do
+    if (rect.isEmpty()) rect = QRect(0, 0, 1, 1);
+
+    // Transparent entry doubles as "keep what is already there"
+    QVector<QRgb> table = m_pending.colorTable();
+    int keep = -1;
+    for (int i = 0; i < table.size(); ++i) {
+        if (qAlpha(table[i]) == 0) { keep = i; break; }
+    }
+    if (keep < 0 && table.size() < 256) {
+        keep = table.size();
+        table.append(qRgba(0, 0, 0, 0));
+    }
+
+    QImage sub(rect.size(), QImage::Format_Indexed8);
+    sub.setColorTable(table);
+    for (int y = 0; y < rect.height(); ++y) {
+        const int cy = rect.y() + y;
+        const uchar *src  = m_pending.constScanLine(cy) + rect.x();
+        const QRgb  *now  = reinterpret_cast<const QRgb *>(m_pendingShown.constScanLine(cy)) + rect.x();
+        const QRgb  *was  = reinterpret_cast<const QRgb *>(m_base.constScanLine(cy)) + rect.x();
+        uchar *dst = sub.scanLine(y);
+        for (int x = 0; x < rect.width(); ++x)
+            dst[x] = (keep >= 0 && now[x] == was[x]) ? uchar(keep) : src[x];
+    }
+
+    if (!m_encoder->addFrame(sub, rect.topLeft(), m_pendingDelay, disposal, errOut))
+        return false;
+
+    // What the decoder has on screen once this frame is disposed of
+    m_base = m_pendingShown;
+    if (disposal == GifEncoder::DisposeBackground) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            QRgb *row = reinterpret_cast<QRgb *>(m_base.scanLine(y));
+            std::fill(row + rect.left(), row + rect.right() + 1, 0u);
+        }
+    }
+
+    m_hasPending = false;
+    m_pending = QImage();
+    m_pendingShown = QImage();
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef FRAMEOPTIMIZER_H
+#define FRAMEOPTIMIZER_H
+
+#include <QImage>
+#include <QRect>
+#include <QString>
+
+class GifEncoder;
+
+// Inter-frame optimizer in front of GifEncoder.
+//
+// Each frame is compared against what the decoder will already have on screen.
+// Only the bounding box of the changed pixels is written, and pixels inside it
+// that did not change become transparent ("keep"). Those long runs of one index
+// compress very well in LZW.
+//
+// A frame's disposal method is only decided once the next frame is known, so
+// one frame is always held back:
+//  - DisposeNone when the next frame can be drawn over this one, i.e. it never
+//    needs a pixel to turn transparent again;
+//  - DisposeBackground otherwise, with the rectangle grown to cover every pixel
+//    the next frame needs cleared.
+// The last frame clears the whole canvas, so a looping animation restarts on
+// an empty screen.
+//
+// A frame that looks exactly like the held-back one (after palette reduction)
+// is not written at all; the held-back frame's delay grows by its delay.
+//
+// Frames are expected to be full-canvas; Indexed8 frames keep their palette,
+// anything else goes through GifEncoder::quantize() first.
+class FrameOptimizer
+{
+public:
+    explicit FrameOptimizer(GifEncoder *encoder);
+
+    bool addFrame(const QImage &frame, int delayCs, QString *errOut);
+
+    // Writes the held-back frame. Call once after the last addFrame().
+    bool flush(QString *errOut);
+
+private:
+    bool emitPending(const QImage *nextShown, QString *errOut);
+    bool extendPending(int delayCs);
+
+    GifEncoder *m_encoder;
+
+    QImage m_base;           // canvas before the pending frame is drawn (ARGB32, transparent == 0)
+    QImage m_pending;        // Indexed8 frame waiting for its disposal decision
+    QImage m_pendingShown;   // the pending frame as it appears on the canvas (ARGB32)
+    QRect  m_pendingRect;    // where it differs from m_base
+    int    m_pendingDelay = 0;
+    bool   m_hasPending = false;
+};
+
+#endif // FRAMEOPTIMIZER_H
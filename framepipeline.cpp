@@ -0,0 +1,828 @@
+#include "framepipeline.h"
+#include "runprofile.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QHash>
+#include <QProcess>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <atomic>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// --- Helper: find ImageMagick binary ("magick" preferred; fall back to "convert")
+static QString findImageMagick()
+{
+    // Try v7 "magick" first
+    QStringList candidates = { "magick", "convert" };
+    for (const QString &bin : candidates) {
+        QString which = QStandardPaths::findExecutable(bin);
+        if (!which.isEmpty()) return which;
+    }
+    return QString();
+}
+
+// --- Helper: copy 'tmpPath' into 'out' (opened here, left uncommitted)
+static bool copyToSaveFile(const QString &tmpPath, QSaveFile *out, QString *errOut)
+{
+    QFile in(tmpPath);
+    if (!in.open(QIODevice::ReadOnly)) {
+        if (errOut) *errOut = QString("ImageMagick wrote no GIF: %1").arg(in.errorString());
+        return false;
+    }
+    if (!out->open(QIODevice::WriteOnly)) {
+        if (errOut) *errOut = QString("Could not open %1 for writing: %2")
+                                  .arg(out->fileName(), out->errorString());
+        return false;
+    }
+    while (!in.atEnd()) {
+        const QByteArray chunk = in.read(1 << 20);
+        if (out->write(chunk) != chunk.size()) {
+            if (errOut) *errOut = QString("Failed writing GIF: %1").arg(out->errorString());
+            out->cancelWriting();
+            return false;
+        }
+    }
+    return true;
+}
+
+// --- Helper: assemble frames into an animated GIF using ImageMagick
+// Frame t is shown from t/fps seconds on, rounded to centiseconds (the same
+// delays as FramePipeline::frameDelayCs()). 'optimize' lets ImageMagick
+// reduce size and merge repeated frames into longer ones. ImageMagick writes
+// inside 'framesDir'; its GIF is copied into 'outGif' only once it has
+// succeeded, and left uncommitted, so a failed or cancelled run never touches
+// the GIF already at the output path. QSaveFile rather than QFile::rename(),
+// which does not overwrite and may cross file systems.
+static bool assembleGif(const QString &magickBin,
+                        const QString &framesDir,
+                        int fps,
+                        QSaveFile *outGif,
+                        bool optimize,
+                        const std::atomic<bool> *cancel,
+                        QString *errOut)
+{
+    if (fps <= 0) fps = 12;
+
+    // Same arguments for "magick" (IM7) and "convert" (IM6)
+    const QString glob = QDir(framesDir).filePath("frame_*.png");
+    const QString delayCs = QString("%[fx:max(1,floor((t+1)*100/%1+0.5)-floor(t*100/%1+0.5))]").arg(fps);
+
+    // magick -dispose Background frame_*.png -set delay <per frame>
+    //        -layers RemoveDups -layers Optimize -loop 0 out.gif
+    QStringList args;
+    args << "-dispose" << "Background"
+         << glob
+         << "-set" << "delay" << delayCs;
+    if (optimize) args << "-layers" << "RemoveDups" << "-layers" << "Optimize";
+    const QString tmpGif = QDir(framesDir).filePath("assembled.gif");
+    args << "-loop" << "0"
+         << tmpGif;
+
+    QProcess p;
+    p.start(magickBin, args);
+    if (!p.waitForStarted(15000)) {
+        if (errOut) *errOut = "Failed to start ImageMagick.";
+        return false;
+    }
+    // Poll rather than block, so a cancel can kill the assembly
+    while (!p.waitForFinished(100)) {
+        if (p.state() == QProcess::NotRunning) break;
+        if (cancel && cancel->load()) {
+            p.kill();
+            p.waitForFinished(-1);
+            if (errOut) *errOut = "Cancelled.";
+            return false;
+        }
+    }
+    const int exitCode = p.exitCode();
+    if (exitCode != 0) {
+        if (errOut) *errOut = QString("ImageMagick failed (exit %1): %2")
+                                  .arg(exitCode, 0, 10)
+                                  .arg(QString::fromUtf8(p.readAllStandardError()));
+        return false;
+    }
+    return copyToSaveFile(tmpGif, outGif, errOut);
+}
+
+// --- Helper: 2x2 box average of an ARGB32_Premultiplied image, rounded
+//     (an odd last row/column is dropped)
+static QImage halveBox(const QImage &src)
+{
+    const int w = src.width() / 2;
+    const int h = src.height() / 2;
+    QImage dst(w, h, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < h; ++y) {
+        const QRgb *r0 = reinterpret_cast<const QRgb *>(src.constScanLine(2 * y));
+        const QRgb *r1 = reinterpret_cast<const QRgb *>(src.constScanLine(2 * y + 1));
+        QRgb *out = reinterpret_cast<QRgb *>(dst.scanLine(y));
+        int x = 0;
+#if defined(__SSE2__)
+        // 8 source pixels per row -> 4 out; channels summed in 16 bits
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two  = _mm_set1_epi16(2);
+        const auto pairSums = [&](const QRgb *a, const QRgb *b) {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+            const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+            const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+            const __m128i sum = _mm_unpacklo_epi64(_mm_add_epi16(lo, _mm_srli_si128(lo, 8)),
+                                                   _mm_add_epi16(hi, _mm_srli_si128(hi, 8)));
+            return _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+        };
+        for (; x + 4 <= w; x += 4) {
+            const __m128i p01 = pairSums(r0 + 2 * x,     r1 + 2 * x);
+            const __m128i p23 = pairSums(r0 + 2 * x + 4, r1 + 2 * x + 4);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(p01, p23));
+        }
+#endif
+        for (; x < w; ++x) {
+            const QRgb a = r0[2 * x], b = r0[2 * x + 1], c = r1[2 * x], d = r1[2 * x + 1];
+            QRgb px = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                const uint sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF)
+                               + ((c >> shift) & 0xFF) + ((d >> shift) & 0xFF);
+                px |= ((sum + 2) >> 2) << shift;
+            }
+            out[x] = px;
+        }
+    }
+    return dst;
+}
+
+// --- Helper: area downscale to 'size': box halvings while the image is at
+//     least twice as large, then one smooth resample for what is left
+static QImage downscale(const QImage &src, const QSize &size)
+{
+    QImage img = (src.format() == QImage::Format_ARGB32_Premultiplied)
+                     ? src : src.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    while (img.width() >= 2 * size.width() && img.height() >= 2 * size.height())
+        img = halveBox(img);
+    if (img.size() != size)
+        img = img.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    return img;
+}
+
+// --- Helper: bytes held by a frame and its smaller outputs
+static qint64 bytesOf(const QVector<QImage> &frames)
+{
+    qint64 bytes = 0;
+    for (const QImage &f : frames) bytes += f.sizeInBytes();
+    return bytes;
+}
+
+// --- Helper: tasks started on a thread pool and waited for as a group.
+//     Unlike QThreadPool::waitForDone() this works on a shared pool: only
+//     this group's tasks are waited for, not everyone else's.
+namespace {
+class TaskGroup
+{
+public:
+    explicit TaskGroup(QThreadPool *pool) : m_pool(pool) {}
+    ~TaskGroup() { wait(); }
+
+    void start(const std::function<void()> &task)
+    {
+        {
+            QMutexLocker lock(&m_mutex);
+            ++m_pending;
+        }
+        m_pool->start([this, task]{
+            task();
+            QMutexLocker lock(&m_mutex);
+            if (--m_pending == 0) m_idle.wakeAll();
+        });
+    }
+
+    void wait()
+    {
+        QMutexLocker lock(&m_mutex);
+        while (m_pending > 0)
+            m_idle.wait(&m_mutex);
+    }
+
+private:
+    QThreadPool   *m_pool;
+    QMutex         m_mutex;
+    QWaitCondition m_idle;
+    int            m_pending = 0;
+};
+} // namespace
+
+// Frames sampled (evenly across the run) to build a global palette
+static const int kPaletteSampleFrames = 8;
+
+// Memory for frames kept to be reused by later frames with the same pose
+static const qint64 kRetainBytes       = 256ll * 1024 * 1024;
+static const int    kMinRetainedFrames = 8;
+
+FramePipeline::FramePipeline(int queueCapacity)
+    : m_capacity(qMax(1, queueCapacity))
+    , m_workers(defaultWorkerCount())
+    , m_paletteMode(defaultPaletteMode())
+    , m_optimize(defaultOptimizeFrames())
+{
+}
+
+int FramePipeline::defaultWorkerCount()
+{
+    QSettings s("MyCompany", "GifMaker");
+    const int configured = s.value("renderThreads", 0).toInt();
+    return configured > 0 ? configured : qMax(1, QThread::idealThreadCount());
+}
+
+FramePipeline::PaletteMode FramePipeline::defaultPaletteMode()
+{
+    QSettings s("MyCompany", "GifMaker");
+    return s.value("paletteMode", "global").toString() == "perframe" ? PerFramePalette : GlobalPalette;
+}
+
+bool FramePipeline::defaultOptimizeFrames()
+{
+    QSettings s("MyCompany", "GifMaker");
+    return s.value("optimizeFrames", true).toBool();
+}
+
+FramePipeline::~FramePipeline()
+{
+    if (m_thread) abort();
+    delete m_assembled;
+    qDeleteAll(m_outputs);
+}
+
+// The built-in encoder is the default; ImageMagick is only used when the
+// "gifEncoder" setting is "imagemagick" and a binary can actually be found.
+bool FramePipeline::start(const QString &outGifPath, const QSize &canvasSize, int fps, QString *errOut)
+{
+    if (m_thread) {
+        if (errOut) *errOut = "Frame pipeline already started.";
+        return false;
+    }
+    if (isCancelled()) {
+        if (errOut) *errOut = "Cancelled.";
+        return false;
+    }
+
+    m_outPath    = outGifPath;
+    m_canvasSize = canvasSize;
+    m_fps        = fps > 0 ? fps : 12;
+    m_frameIndex = 0;
+    m_framesEncoded = 0;
+    m_totalFrames = 0;
+    m_closing    = false;
+    m_failed     = false;
+    m_error.clear();
+    m_queue.clear();
+    qDeleteAll(m_outputs);
+    m_outputs.clear();
+
+    QSettings s("MyCompany", "GifMaker");
+    m_magick = (s.value("gifEncoder", "native").toString() == "imagemagick") ? findImageMagick() : QString();
+    m_optimizer = FrameOptimizer(&m_encoder);
+    // Enough idle buffers for the render window, the queue and the frame
+    // being encoded
+    m_framePool.reset(canvasSize, m_workers * 2 + m_capacity + 2);
+
+    if (m_sink) {
+        m_magick.clear();   // frames go to the sink; nothing is written
+    } else if (!m_magick.isEmpty()) {
+        m_framesTmp = new QTemporaryDir("gif_frames_XXXXXX");
+        if (!m_framesTmp->isValid()) {
+            if (errOut) *errOut = "Could not create temp directory.";
+            delete m_framesTmp;
+            m_framesTmp = nullptr;
+            return false;
+        }
+    } else if (!m_encoder.open(outGifPath, canvasSize, 0 /*loop forever*/, errOut)) {
+        return false;
+    }
+
+    m_thread = QThread::create([this]{ encodeLoop(); });
+    m_thread->start();
+    return true;
+}
+
+// Same encoder choice, palette mode and optimizer as this pipeline, fed
+// by it: it never renders, so it needs no workers or frame pool
+bool FramePipeline::addOutput(const QString &outGifPath, const QSize &canvasSize, QString *errOut)
+{
+    if (!m_thread) {
+        if (errOut) *errOut = "Frame pipeline was not started.";
+        return false;
+    }
+    if (m_sink) {
+        if (errOut) *errOut = "A frame sink has no extra outputs.";
+        return false;
+    }
+    if (canvasSize.width() > m_canvasSize.width() || canvasSize.height() > m_canvasSize.height()) {
+        if (errOut) *errOut = "Extra outputs must not be larger than the rendered frames.";
+        return false;
+    }
+
+    FramePipeline *out = new FramePipeline(m_capacity);
+    out->m_workers     = 1;
+    out->m_paletteMode = m_paletteMode;
+    out->m_optimize    = m_optimize;
+    out->m_cancel      = m_cancel;
+    out->m_profile     = m_profile;
+    if (!out->start(outGifPath, canvasSize, m_fps, errOut)) {
+        delete out;
+        return false;
+    }
+
+    // Largest first, so each one is scaled down from the one before it
+    auto it = m_outputs.begin();
+    while (it != m_outputs.end() && (*it)->m_canvasSize.width() >= canvasSize.width()) ++it;
+    m_outputs.insert(it, out);
+    return true;
+}
+
+// The rendered frame first, then each extra output scaled down from the
+// previous (larger) one
+QVector<QImage> FramePipeline::scaledFrames(const QImage &frame, int index) const
+{
+    QVector<QImage> frames { frame };
+    if (m_outputs.isEmpty() || frame.isNull()) return frames;
+    RunProfile::TraceScope scale(m_profile, "downscale", index);
+    for (const FramePipeline *out : m_outputs)
+        frames.append(downscale(frames.last(), out->m_canvasSize));
+    return frames;
+}
+
+bool FramePipeline::push(QImage frame)
+{
+    const QVector<QImage> frames = scaledFrames(frame, -1);
+    for (int k = 0; k < m_outputs.size(); ++k)
+        if (!m_outputs[k]->enqueue(frames[k + 1])) return false;
+    return enqueue(std::move(frame));
+}
+
+bool FramePipeline::enqueue(QImage frame)
+{
+    QMutexLocker lock(&m_mutex);
+    if (!m_failed && m_queue.size() >= m_capacity) {
+        RunProfile::TraceScope stall(m_profile, "wait: queue full");
+        while (!m_failed && m_queue.size() >= m_capacity)
+            m_notFull.wait(&m_mutex);   // backpressure: wait for the encoder to catch up
+    }
+    if (m_failed || isCancelled()) return false;
+
+    if (m_profile) m_profile->frameHeld(frame.sizeInBytes());
+    m_queue.enqueue(std::move(frame));
+    if (m_profile) m_profile->traceCounter("queue", m_queue.size());
+    m_notEmpty.wakeOne();
+    return true;
+}
+
+// Renders the frames the global palette is built from, picked evenly from
+// 'candidates'. They are kept and reused by renderFrames(), so nothing is
+// rendered twice.
+QHash<int, QImage> FramePipeline::renderSamples(const QVector<int> &candidates,
+                                                const std::function<QImage(int)> &renderFrame)
+{
+    QHash<int, QImage> samples;
+    const int count = qMin(int(candidates.size()), kPaletteSampleFrames);
+    QList<int> indices;
+    for (int k = 0; k < count; ++k)
+        indices.append(candidates[int(qint64(k) * candidates.size() / count)]);
+
+    if (m_workers <= 1) {
+        for (int i : indices) {
+            if (isCancelled()) break;
+            samples.insert(i, renderFrame(i));
+        }
+        return samples;
+    }
+
+    QThreadPool ownPool;
+    ownPool.setMaxThreadCount(m_workers);
+    QMutex samplesMutex;
+    TaskGroup tasks(m_pool ? m_pool : &ownPool);
+    for (int i : indices) {
+        tasks.start([&, i]{
+            if (isCancelled()) return;
+            QImage frame = renderFrame(i);
+            QMutexLocker lock(&samplesMutex);
+            samples.insert(i, std::move(frame));
+        });
+    }
+    tasks.wait();
+    return samples;
+}
+
+// Reduce a rendered frame to its GIF palette (runs on the render workers).
+// Frames that fit in 255 colours always get their own exact palette; the
+// shared one is only for frames that need real colour reduction.
+// ImageMagick does its own colour reduction, so its frames are left alone.
+QImage FramePipeline::toPalette(const QImage &frame, const ColorQuantizer &shared, int index) const
+{
+    if (m_sink || !m_magick.isEmpty() || frame.format() == QImage::Format_Indexed8) return frame;
+    RunProfile::Scope quantize(m_profile, RunProfile::Quantize, index);
+    if (shared.isNull() || ColorQuantizer::hasFewColors(frame)) return ColorQuantizer::quantize(frame);
+    return shared.map(frame);
+}
+
+bool FramePipeline::renderFrames(int totalFrames, const std::function<QImage(int)> &renderFrame)
+{
+    return renderFrames(totalFrames, std::function<QString(int)>(), renderFrame);
+}
+
+// Frame plan: which frames are rendered, which reuse an earlier frame with the
+// same pose, and how long each reused frame has to be kept.
+FramePipeline::FramePlan FramePipeline::planFrames(int totalFrames,
+                                                   const std::function<QString(int)> &poseKey) const
+{
+    FramePlan plan;
+    plan.source.resize(totalFrames);
+    plan.retain.fill(false, totalFrames);
+    plan.release.fill(-1, totalFrames);
+    for (int i = 0; i < totalFrames; ++i) plan.source[i] = i;
+    if (!poseKey) return plan;
+
+    QVector<QString> keys(totalFrames);
+    QHash<QString, int> lastUse;
+    for (int i = 0; i < totalFrames; ++i) {
+        keys[i] = poseKey(i);
+        lastUse.insert(keys[i], i);
+    }
+
+    // Bounded by memory: a pose that cannot be kept is simply rendered again.
+    // A kept frame holds a copy for every output (see addOutput()).
+    qint64 frameBytes = qint64(m_canvasSize.width()) * m_canvasSize.height() * 4;
+    for (const FramePipeline *out : m_outputs)
+        frameBytes += qint64(out->m_canvasSize.width()) * out->m_canvasSize.height() * 4;
+    frameBytes = qMax<qint64>(1, frameBytes);
+    const int budget = int(qBound<qint64>(kMinRetainedFrames, kRetainBytes / frameBytes, totalFrames));
+
+    QHash<QString, int> live;   // pose -> frame currently kept for it
+    for (int i = 0; i < totalFrames; ++i) {
+        const QString &key = keys[i];
+        const auto it = live.constFind(key);
+        if (it != live.constEnd()) {
+            plan.source[i] = it.value();
+        } else if (lastUse.value(key) > i && live.size() < budget) {
+            live.insert(key, i);
+            plan.retain[i] = true;
+        }
+
+        if (lastUse.value(key) == i && live.contains(key))
+            plan.release[i] = live.take(key);
+    }
+    return plan;
+}
+
+bool FramePipeline::renderFrames(int totalFrames,
+                                 const std::function<QString(int)> &poseKey,
+                                 const std::function<QImage(int)> &renderFrameUntimed)
+{
+    if (totalFrames <= 0) return true;
+    m_totalFrames = totalFrames;
+    if (m_profile) m_profile->traceThread("generator");
+
+    const std::function<QImage(int)> renderFrame = !m_profile ? renderFrameUntimed
+                                                              : [&](int i) {
+        m_profile->traceThread("render");
+        RunProfile::Scope render(m_profile, RunProfile::Render, i);
+        QImage frame = renderFrameUntimed(i);
+        render.stop(frame.sizeInBytes());
+        return frame;
+    };
+
+    const FramePlan plan = planFrames(totalFrames, poseKey);
+    QVector<int> rendered;
+    for (int i = 0; i < totalFrames; ++i)
+        if (plan.source[i] == i) rendered.append(i);
+
+    // Global palette: built once from sampled frames, then shared read-only
+    // (each extra output gets its own, from the same samples scaled down)
+    QHash<int, QImage> samples;
+    QVector<ColorQuantizer> shared(1 + m_outputs.size());
+    if (m_paletteMode == GlobalPalette && m_magick.isEmpty() && !m_sink) {
+        samples = renderSamples(rendered, renderFrame);
+        QList<int> order = samples.keys();
+        std::sort(order.begin(), order.end());   // stable palette order run to run
+        QVector<QList<QImage>> frames(shared.size());
+        for (int i : order) {
+            const QVector<QImage> scaled = scaledFrames(samples.value(i), i);
+            for (int k = 0; k < scaled.size(); ++k) frames[k].append(scaled[k]);
+        }
+        RunProfile::Scope quantize(m_profile, RunProfile::Quantize);
+        for (int k = 0; k < shared.size(); ++k)
+            shared[k] = ColorQuantizer(ColorQuantizer::buildPalette(frames[k]));
+    }
+    if (isCancelled()) return false;
+
+    // A finished frame: [0] for this output, [k] for m_outputs[k - 1]
+    typedef QVector<QImage> FrameSet;
+    auto produce = [&](int i) -> FrameSet {
+        const auto it = samples.constFind(i);
+        FrameSet set = scaledFrames(it != samples.constEnd() ? it.value() : renderFrame(i), i);
+        set[0] = toPalette(set[0], shared[0], i);
+        for (int k = 1; k < set.size(); ++k)
+            set[k] = m_outputs[k - 1]->toPalette(set[k], shared[k], i);
+        return set;
+    };
+
+    // Finished frames kept for later frames with the same pose (implicitly
+    // shared, so a reuse costs no copy)
+    QHash<int, FrameSet> kept;
+    auto emitFrame = [&](int i, const FrameSet &set) -> bool {
+        if (set.size() != shared.size()) return false;
+        if (plan.retain[i]) {
+            kept.insert(i, set);
+            if (m_profile) m_profile->frameHeld(bytesOf(set));
+        }
+        if (plan.release[i] >= 0) {
+            if (m_profile) m_profile->frameReleased(bytesOf(kept.value(plan.release[i])));
+            kept.remove(plan.release[i]);
+        }
+        for (int k = 1; k < set.size(); ++k)
+            if (!m_outputs[k - 1]->enqueue(set[k])) return false;
+        return enqueue(set[0]);
+    };
+
+    if (m_workers <= 1) {
+        for (int i = 0; i < totalFrames; ++i) {
+            if (isCancelled()) return false;
+            const FrameSet set = (plan.source[i] == i) ? produce(i) : kept.value(plan.source[i]);
+            if (!emitFrame(i, set)) return false;
+        }
+        return true;
+    }
+
+    QThreadPool ownPool;
+    ownPool.setMaxThreadCount(m_workers);
+
+    // Reorder buffer: workers finish out of order, frames are pushed by index.
+    // Only 'window' frames may be in flight so memory stays bounded.
+    QMutex               doneMutex;
+    QWaitCondition       doneCond;
+    QHash<int, FrameSet> done;
+    std::atomic<bool>    stop(false);
+    const int window = m_workers * 2;
+    TaskGroup tasks(m_pool ? m_pool : &ownPool);
+
+    int submitted = 0;   // position in 'rendered'
+    bool ok = true;
+    for (int next = 0; next < totalFrames; ++next) {
+        while (submitted < rendered.size() && rendered[submitted] - next < window) {
+            const int i = rendered[submitted++];
+            tasks.start([&, i]{
+                if (stop.load()) return;
+                // Cancelled: hand back an empty frame so the wait below ends
+                FrameSet set = isCancelled() ? FrameSet() : produce(i);
+                if (m_profile) m_profile->frameHeld(bytesOf(set));
+                QMutexLocker lock(&doneMutex);
+                done.insert(i, std::move(set));
+                doneCond.wakeAll();
+            });
+        }
+
+        FrameSet set;
+        if (plan.source[next] != next) {
+            set = kept.value(plan.source[next]);   // pushed earlier, so already here
+        } else {
+            QMutexLocker lock(&doneMutex);
+            if (!done.contains(next)) {
+                RunProfile::TraceScope stall(m_profile, "wait: next frame", next);
+                while (!done.contains(next))
+                    doneCond.wait(&doneMutex);
+            }
+            set = done.take(next);
+            if (m_profile) m_profile->frameReleased(bytesOf(set));
+        }
+        if (isCancelled() || !emitFrame(next, set)) { ok = false; break; }
+    }
+
+    stop.store(true);
+    tasks.wait();
+    return ok;
+}
+
+void FramePipeline::encodeLoop()
+{
+    if (m_profile) m_profile->traceThread("encoder");
+    for (;;) {
+        QImage frame;
+        {
+            QMutexLocker lock(&m_mutex);
+            if (m_queue.isEmpty() && !m_closing && !m_failed) {
+                RunProfile::TraceScope stall(m_profile, "wait: queue empty");
+                while (m_queue.isEmpty() && !m_closing && !m_failed)
+                    m_notEmpty.wait(&m_mutex);
+            }
+            if (!m_failed && isCancelled()) {
+                m_failed = true;
+                m_error  = "Cancelled.";
+                m_queue.clear();
+                m_notFull.wakeAll();
+            }
+            if (m_failed || m_queue.isEmpty()) return;   // aborted, or closing with nothing left
+            frame = m_queue.dequeue();
+            if (m_profile) m_profile->traceCounter("queue", m_queue.size());
+            m_notFull.wakeOne();
+        }
+
+        QString err;
+        const bool ok = consume(frame, &err);
+        if (m_profile) m_profile->frameReleased(frame.sizeInBytes());
+        if (!ok) {
+            QMutexLocker lock(&m_mutex);
+            m_failed = true;
+            m_error  = err;
+            m_queue.clear();
+            m_notFull.wakeAll();
+            return;
+        }
+        if (m_progress) m_progress(m_framesEncoded, m_totalFrames);
+    }
+}
+
+// Frame i starts at i / fps seconds, rounded to the GIF's centisecond clock.
+// The delays then add up to the exact run time (24 fps: 4, 4, 5, 4, 4, 4, ...)
+// instead of every frame being truncated to 100 / fps.
+int FramePipeline::frameDelayCs(int index) const
+{
+    const auto startCs = [this](qint64 frame) { return (frame * 100 + m_fps / 2) / m_fps; };
+    return qMax<qint64>(1, startCs(index + 1) - startCs(index));
+}
+
+bool FramePipeline::consume(const QImage &frame, QString *errOut)
+{
+    RunProfile::Scope encode(m_profile, RunProfile::Encode, m_framesEncoded);
+    const int delayCs = frameDelayCs(m_framesEncoded);
+    ++m_framesEncoded;
+    if (m_sink) {
+        m_sink(frame);
+        return true;
+    }
+    if (m_magick.isEmpty()) {
+        return m_optimize ? m_optimizer.addFrame(frame, delayCs, errOut)
+                          : m_encoder.addFrame(frame, delayCs, errOut);
+    }
+
+    // ImageMagick fallback: stream frames to PNG files, assemble in finalize()
+    const QString framesDir = QDir(m_framesTmp->path()).filePath("frames");
+    if (m_frameIndex == 0) QDir().mkpath(framesDir);
+    const QString fn = QString("%1/frame_%2.png")
+                           .arg(framesDir)
+                           .arg(m_frameIndex, 4, 10, QChar('0'));
+    if (!frame.save(fn, "PNG")) {
+        if (errOut) *errOut = QString("Failed saving %1").arg(fn);
+        return false;
+    }
+    ++m_frameIndex;
+    return true;
+}
+
+// Encodes everything into the output file but leaves it uncommitted (see commit())
+bool FramePipeline::finalize(QString *errOut)
+{
+    if (m_sink) return true;
+    if (m_magick.isEmpty()) {
+        if (m_optimize && !m_optimizer.flush(errOut)) {
+            m_encoder.cancel();
+            return false;
+        }
+        RunProfile::Scope encode(m_profile, RunProfile::Encode);
+        const bool ok = m_encoder.closePending(errOut);
+        encode.stop(ok ? m_encoder.bytesWritten() : 0);
+        return ok;
+    }
+
+    const QString framesDir = QDir(m_framesTmp->path()).filePath("frames");
+    RunProfile::Scope assemble(m_profile, RunProfile::Assemble);
+    m_assembled = new QSaveFile(m_outPath);
+    const bool ok = assembleGif(m_magick, framesDir, m_fps, m_assembled, true, m_cancel, errOut);
+    assemble.stop(ok ? m_assembled->size() : 0);
+    delete m_framesTmp;
+    m_framesTmp = nullptr;
+    if (!ok) {
+        delete m_assembled;   // never committed: the output path is untouched
+        m_assembled = nullptr;
+    }
+    return ok;
+}
+
+// Puts the file written by finalize() in place
+bool FramePipeline::commit(QString *errOut)
+{
+    if (m_sink) return true;
+    if (!m_assembled) return m_encoder.commit(errOut);
+
+    const bool ok = m_assembled->commit();
+    if (!ok && errOut) *errOut = QString("Failed to save GIF: %1").arg(m_assembled->errorString());
+    delete m_assembled;
+    m_assembled = nullptr;
+    return ok;
+}
+
+void FramePipeline::stopThread()
+{
+    if (!m_thread) return;
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+bool FramePipeline::finish(QString *errOut)
+{
+    if (!finishPending(errOut)) return false;
+
+    // Every output has been encoded; committing is only a rename each. The
+    // extra outputs go first, so a failed rename never leaves this output
+    // replaced without them; the error names the files already in place.
+    QStringList written;
+    QString err;
+    bool ok = true;
+    for (FramePipeline *out : m_outputs) {
+        if (ok && out->commit(&err)) written << out->m_outPath;
+        else { ok = false; out->abort(); }
+    }
+    qDeleteAll(m_outputs);
+    m_outputs.clear();
+
+    if (ok && commit(&err)) return true;
+    abort();
+    if (errOut) {
+        *errOut = err;
+        if (!written.isEmpty()) *errOut += QString(" (already written: %1)").arg(written.join(", "));
+    }
+    return false;
+}
+
+// finish() up to the commit: this output and the extra ones are encoded into
+// uncommitted files. On failure all of them are discarded, so the files
+// already at the output paths are left as they were.
+bool FramePipeline::finishPending(QString *errOut)
+{
+    if (!m_thread) {
+        if (errOut) *errOut = "Frame pipeline was not started.";
+        return false;
+    }
+
+    {
+        QMutexLocker lock(&m_mutex);
+        m_closing = true;
+        m_notEmpty.wakeAll();
+    }
+    stopThread();
+
+    // Cancelled while the encoder sat idle: it never saw the flag
+    if (!m_failed && isCancelled()) {
+        m_failed = true;
+        m_error  = "Cancelled.";
+    }
+
+    for (FramePipeline *out : m_outputs) {
+        if (m_failed) break;
+        QString err;
+        if (!out->finishPending(&err)) {
+            m_failed = true;
+            m_error  = err;
+        }
+    }
+    if (!m_failed) {
+        QString err;
+        if (!finalize(&err)) {
+            m_failed = true;
+            m_error  = err;
+        }
+    }
+
+    if (m_failed) {
+        if (errOut) *errOut = m_error;
+        abort();
+        return false;
+    }
+    return true;
+}
+
+void FramePipeline::abort()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_failed = true;
+        if (m_error.isEmpty()) m_error = "Cancelled.";
+        m_queue.clear();
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+    stopThread();
+    m_encoder.cancel();
+    delete m_framesTmp;
+    m_framesTmp = nullptr;
+    delete m_assembled;   // uncommitted: discarded
+    m_assembled = nullptr;
+
+    for (FramePipeline *out : m_outputs) out->abort();
+    qDeleteAll(m_outputs);
+    m_outputs.clear();
+}
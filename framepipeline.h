@@ -0,0 +1,208 @@
+#ifndef FRAMEPIPELINE_H
+#define FRAMEPIPELINE_H
+
+#include <QString>
+#include <QImage>
+#include <QSize>
+#include <QQueue>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QTemporaryDir>
+#include <functional>
+#include <atomic>
+#include "gifencoder.h"
+#include "colorquantizer.h"
+#include "frameoptimizer.h"
+#include "framepool.h"
+
+class QThread;
+class QThreadPool;
+class QSaveFile;
+class RunProfile;
+
+// Streaming render -> encode hand-off.
+//
+// The generator pushes frames as it renders them; a dedicated encoder thread
+// pops them from a small bounded queue and writes them to the GIF right away.
+// push() blocks while the queue is full, so at most 'queueCapacity' frames
+// (plus the one being rendered and the one being encoded) are alive at once,
+// no matter how long the animation is.
+//
+// Frames that only depend on their index can be rendered on a thread pool with
+// renderFrames(); they are still encoded strictly in index order, so the
+// output is identical whatever the worker count. The workers also reduce each
+// frame to its GIF palette, so the encoder thread only has to compress.
+//
+//   FramePipeline pipeline;
+//   if (!pipeline.start(outGif, canvasSize, fps, &err)) return false;
+//   pipeline.renderFrames(totalFrames, [&](int i) { return renderFrame(i); });
+//   return pipeline.finish(&err);
+class FramePipeline
+{
+public:
+    explicit FramePipeline(int queueCapacity = 4);
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline &) = delete;
+    FramePipeline &operator=(const FramePipeline &) = delete;
+
+    bool start(const QString &outGifPath, const QSize &canvasSize, int fps, QString *errOut);
+
+    // Hands a frame to the encoder thread; blocks while the queue is full.
+    // Returns false once encoding has failed (stop rendering, then call finish()).
+    bool push(QImage frame);
+
+    // Renders frames 0..totalFrames-1 with 'renderFrame' on workerCount() threads
+    // and pushes them in order. 'renderFrame' must be safe to call concurrently.
+    // Returns false if encoding failed part-way.
+    bool renderFrames(int totalFrames, const std::function<QImage(int)> &renderFrame);
+
+    // Same, for animations that revisit poses: frames with equal 'poseKey'
+    // values must render identically. Each pose is rendered and quantized once
+    // and the finished frame is reused wherever it comes back (within a memory
+    // budget; a pose that cannot be kept is rendered again).
+    bool renderFrames(int totalFrames,
+                      const std::function<QString(int)> &poseKey,
+                      const std::function<QImage(int)> &renderFrame);
+
+    // Render threads used by renderFrames(); defaults to the "renderThreads"
+    // setting, or QThread::idealThreadCount() when that is 0/unset.
+    void setWorkerCount(int workers) { m_workers = qMax(1, workers); }
+    int  workerCount() const { return m_workers; }
+    static int defaultWorkerCount();
+
+    // Render on a shared pool (not owned) instead of a private one per call,
+    // so several pipelines running at once share the same cores. workerCount()
+    // still bounds how many of this pipeline's frames are in flight.
+    void setThreadPool(QThreadPool *pool) { m_pool = pool; }
+    QThreadPool *threadPool() const { return m_pool; }
+
+    // How renderFrames() picks palettes for the native encoder:
+    //  GlobalPalette   - one median-cut palette from frames sampled across the
+    //                    whole run, shared by every frame (no palette flicker)
+    //  PerFramePalette - each frame gets its own palette
+    // Defaults to the "paletteMode" setting ("global" or "perframe").
+    enum PaletteMode { GlobalPalette, PerFramePalette };
+    void setPaletteMode(PaletteMode mode) { m_paletteMode = mode; }
+    PaletteMode paletteMode() const { return m_paletteMode; }
+    static PaletteMode defaultPaletteMode();
+
+    // Write only the changed rectangle of each frame (see FrameOptimizer).
+    // Defaults to the "optimizeFrames" setting (on).
+    void setOptimizeFrames(bool on) { m_optimize = on; }
+    bool optimizeFrames() const { return m_optimize; }
+    static bool defaultOptimizeFrames();
+
+    // Cancellation: once '*flag' is set, rendering and encoding stop after the
+    // frame each thread is on, and finish() discards the output and fails with
+    // "Cancelled.". The flag is only read; it must outlive the pipeline.
+    void setCancelFlag(const std::atomic<bool> *flag) { m_cancel = flag; }
+    bool isCancelled() const { return m_cancel && m_cancel->load(); }
+
+    // Called on the encoder thread after each frame is written, with the
+    // frame count from renderFrames() (0 for frames only push()ed)
+    void setProgress(const std::function<void(int done, int total)> &progress) { m_progress = progress; }
+
+    // Preview: frames go to 'sink' (on the encoder thread, in order) instead of
+    // a GIF. No palette reduction or frame optimizing; start()'s path is unused.
+    void setFrameSink(const std::function<void(const QImage &frame)> &sink) { m_sink = sink; }
+
+    // Per-stage timing (render, quantize, encode, assemble) and the frame
+    // memory held between render and encode go to 'profile' (not owned).
+    // When it is tracing, each frame's stages, the threads' waits on each
+    // other and the queue depth are recorded too.
+    void setProfile(RunProfile *profile) { m_profile = profile; }
+
+    // Multi-resolution: also write the run at a smaller 'canvasSize' to
+    // 'outGifPath'. Frames are still rendered once, at start()'s size; each
+    // extra output is box-downscaled from the next larger one on the render
+    // workers (or in push()), gets its own palette and encoder thread, and
+    // is encoded alongside this one. finish() encodes all of them before
+    // committing any (see finish()).
+    // Call after start(), before the first frame; not with a frame sink.
+    bool addOutput(const QString &outGifPath, const QSize &canvasSize, QString *errOut);
+
+    // Recycled canvas-sized frames for the render callbacks (see FramePool);
+    // sized by start(). Buffers come back once the frame has been encoded.
+    FramePool &framePool() { return m_framePool; }
+
+    // Waits for the queue to drain and closes the output. Returns the encoder status.
+    // Files are only put in place once every output has been encoded; until
+    // then, and on failure, whatever was at the output paths is left alone.
+    // Each file is then committed (renamed) in turn, the extra outputs first:
+    // a rename that fails can still leave a partial set, and the error lists
+    // the paths already written.
+    bool finish(QString *errOut);
+
+    // Frames handed to the encoder since start()
+    int framesEncoded() const { return m_framesEncoded; }
+
+    // Centiseconds frame 'index' is shown for: frames start at index / fps
+    // seconds on the GIF's centisecond clock, so the delays vary by one to
+    // keep the total exact. Consecutive identical frames are merged into one
+    // with their delays added (see FrameOptimizer).
+    int frameDelayCs(int index) const;
+
+    // Drops queued frames and discards the output file.
+    void abort();
+
+private:
+    struct FramePlan {
+        QVector<int>  source;    // frame whose image is used (== index when rendered)
+        QVector<bool> retain;    // keep this frame for later reuse
+        QVector<int>  release;   // kept frame that can be dropped after this one, or -1
+    };
+    FramePlan planFrames(int totalFrames, const std::function<QString(int)> &poseKey) const;
+    QHash<int, QImage> renderSamples(const QVector<int> &candidates,
+                                     const std::function<QImage(int)> &renderFrame);
+    QImage toPalette(const QImage &frame, const ColorQuantizer &shared, int index) const;
+    QVector<QImage> scaledFrames(const QImage &frame, int index) const;
+    bool enqueue(QImage frame);
+    void encodeLoop();
+    bool consume(const QImage &frame, QString *errOut);
+    bool finishPending(QString *errOut);
+    bool finalize(QString *errOut);
+    bool commit(QString *errOut);
+    void stopThread();
+
+    const int   m_capacity;
+    int         m_workers;
+    PaletteMode m_paletteMode;
+    bool        m_optimize;
+    QThreadPool *m_pool = nullptr;
+    const std::atomic<bool> *m_cancel = nullptr;
+    std::function<void(int, int)> m_progress;
+    std::function<void(const QImage &)> m_sink;
+    RunProfile *m_profile = nullptr;
+
+    QMutex         m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QQueue<QImage> m_queue;
+    bool           m_closing = false;
+    bool           m_failed  = false;
+    QString        m_error;
+
+    QThread   *m_thread = nullptr;
+    QString    m_outPath;
+    QSize      m_canvasSize;
+    int        m_fps = 12;
+    int        m_frameIndex = 0;
+    int        m_framesEncoded = 0;
+    std::atomic<int> m_totalFrames { 0 };
+
+    // Native encoder (default) or ImageMagick fallback (frames streamed to PNG files).
+    // The optimizer writes only changed rectangles (see setOptimizeFrames()).
+    GifEncoder     m_encoder;
+    FrameOptimizer m_optimizer { &m_encoder };
+    FramePool      m_framePool;
+    QString    m_magick;
+    QTemporaryDir *m_framesTmp = nullptr;
+    QSaveFile     *m_assembled = nullptr;   // ImageMagick's GIF, until commit()
+
+    QVector<FramePipeline *> m_outputs;   // addOutput(), largest first
+};
+
+#endif // FRAMEPIPELINE_H
@@ -0,0 +1,128 @@
+#include "framepool.h"
+#include <QMutex>
+#include <QVector>
+#include <algorithm>
+
+// Shared with every buffer handed out, so a frame that comes back after the
+// pool is gone (or reset) still finds somewhere to go
+struct FramePool::State {
+    QMutex            mutex;
+    QSize             size;
+    int               bytesPerLine = 0;
+    int               maxIdle = 0;
+    bool              closed = false;
+    QVector<Buffer *> idle;
+};
+
+struct FramePool::Buffer {
+    std::shared_ptr<State> state;
+    uchar *data = nullptr;
+    QRect  dirty;              // drawn on by the last frame; 'bg' everywhere else
+    QRgb   bg = 0;             // premultiplied
+    bool   filled = false;
+    bool   rewrites = false;
+};
+
+// --- Helper: fill 'rect' of a buffer with one pixel value
+static void fillRect(uchar *data, int bytesPerLine, const QRect &rect, QRgb px)
+{
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        QRgb *row = reinterpret_cast<QRgb *>(data + qsizetype(y) * bytesPerLine) + rect.left();
+        std::fill(row, row + rect.width(), px);
+    }
+}
+
+FramePool::FramePool()
+    : m_state(std::make_shared<State>())
+{
+}
+
+FramePool::~FramePool()
+{
+    close(m_state);
+}
+
+void FramePool::reset(const QSize &size, int maxIdle)
+{
+    close(m_state);
+    m_state = std::make_shared<State>();
+    m_state->size = size;
+    m_state->bytesPerLine = size.width() * 4;
+    m_state->maxIdle = qMax(0, maxIdle);
+}
+
+QSize FramePool::size() const
+{
+    return m_state->size;
+}
+
+QImage FramePool::acquire(const QColor &bg, const QRect &drawRect, bool rewrites)
+{
+    State &s = *m_state;
+    if (s.size.isEmpty()) return QImage();
+
+    Buffer *b = nullptr;
+    {
+        QMutexLocker lock(&s.mutex);
+        if (!s.idle.isEmpty()) b = s.idle.takeLast();
+    }
+    if (!b) {
+        b = new Buffer;
+        b->state = m_state;
+        b->data = static_cast<uchar *>(qMallocAligned(size_t(s.bytesPerLine) * s.size.height(), 64));
+        if (!b->data) {
+            delete b;
+            return QImage();
+        }
+    }
+
+    // Back to all-background: everything for a new buffer or another colour,
+    // else only what the last frame drew (nothing if it rewrites the same area)
+    const QRect all(QPoint(0, 0), s.size);
+    const QRgb px = qPremultiply(bg.rgba());
+    const QRect target = drawRect & all;
+    if (!b->filled || b->bg != px)
+        fillRect(b->data, s.bytesPerLine, all, px);
+    else if (!(rewrites && b->rewrites && b->dirty == target))
+        fillRect(b->data, s.bytesPerLine, b->dirty, px);
+
+    b->filled   = true;
+    b->bg       = px;
+    b->dirty    = target;
+    b->rewrites = rewrites;
+    return QImage(b->data, s.size.width(), s.size.height(), s.bytesPerLine,
+                  QImage::Format_ARGB32_Premultiplied, &FramePool::release, b);
+}
+
+// QImage cleanup function: the last copy of a frame is gone
+void FramePool::release(void *buffer)
+{
+    Buffer *b = static_cast<Buffer *>(buffer);
+    const std::shared_ptr<State> state = std::move(b->state);
+    {
+        QMutexLocker lock(&state->mutex);
+        if (!state->closed && state->idle.size() < state->maxIdle) {
+            b->state = state;
+            state->idle.append(b);
+            return;
+        }
+    }
+    qFreeAligned(b->data);
+    delete b;
+}
+
+// No more handing out from 'state': its idle buffers are freed now, the
+// ones still out when they come back
+void FramePool::close(const std::shared_ptr<State> &state)
+{
+    QVector<Buffer *> idle;
+    {
+        QMutexLocker lock(&state->mutex);
+        state->closed = true;
+        idle.swap(state->idle);
+    }
+    for (Buffer *b : idle) {
+        qFreeAligned(b->data);
+        delete b;   // drops its reference to the state
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QColor>
+#include <QRect>
+#include <QSize>
+#include <memory>
+
+// Recycled frame buffers for one run.
+//
+// The generators used to allocate and fill a fresh canvas-sized QImage for
+// every frame. acquire() hands out a QImage over a buffer the pool owns
+// instead; when the last copy of that image goes away (the worker has reduced
+// it to its palette, or the encoder is done with it) the buffer goes back to
+// the pool by itself, from whichever thread drops it.
+//
+// Each buffer remembers where its last frame was drawn, so handing it out
+// again only clears that part back to the background:
+//
+//   QImage frame = pipeline.framePool().acquire(bg, warp.bounds(tr));
+//   warp.draw(frame, tr);
+//
+// Safe to call from several threads. Frames may outlive the pool (or a
+// reset()); their buffers are freed when they come back.
+class FramePool
+{
+public:
+    FramePool();
+    ~FramePool();
+
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    // Drops the idle buffers and starts over with frames of 'size', keeping
+    // at most 'maxIdle' buffers around between frames
+    void reset(const QSize &size, int maxIdle);
+    QSize size() const;
+
+    // ARGB32_Premultiplied frame of size(), filled with 'bg'. 'drawRect' is
+    // where the caller is going to draw; it is what gets cleared the next
+    // time this buffer is handed out.
+    //
+    // 'rewrites': the caller writes every pixel it touches without blending,
+    // on the same footprint every frame (the globe's disc). Those pixels are
+    // then left as they are, and a buffer coming back from such a frame with
+    // the same drawRect and bg is not cleared at all.
+    QImage acquire(const QColor &bg, const QRect &drawRect, bool rewrites = false);
+
+private:
+    struct State;
+    struct Buffer;
+    static void release(void *buffer);
+    static void close(const std::shared_ptr<State> &state);
+
+    std::shared_ptr<State> m_state;
+};
+
+#endif // FRAMEPOOL_H
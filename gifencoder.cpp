@@ -0,0 +1,301 @@
+#include "gifencoder.h"
+#include "colorquantizer.h"
+#include <QSaveFile>
+#include <cstring>
+
+namespace {
+
+static void putU16(QByteArray &out, int v)
+{
+    out.append(char(v & 0xFF));
+    out.append(char((v >> 8) & 0xFF));
+}
+
+// --- LZW bit packer: accumulates variable-width codes LSB-first and emits
+//     them as GIF data sub-blocks (<= 255 bytes each).
+class LzwBitWriter
+{
+public:
+    explicit LzwBitWriter(QByteArray &out) : m_out(out) {}
+
+    void write(int code, int codeSize)
+    {
+        m_acc |= quint32(code) << m_bits;
+        m_bits += codeSize;
+        while (m_bits >= 8) {
+            pushByte(char(m_acc & 0xFF));
+            m_acc >>= 8;
+            m_bits -= 8;
+        }
+    }
+
+    void finish()
+    {
+        if (m_bits > 0) pushByte(char(m_acc & 0xFF));
+        m_acc = 0; m_bits = 0;
+        flushBlock();
+        m_out.append(char(0)); // block terminator
+    }
+
+private:
+    void pushByte(char b)
+    {
+        m_block[m_blockLen++] = b;
+        if (m_blockLen == 255) flushBlock();
+    }
+    void flushBlock()
+    {
+        if (m_blockLen == 0) return;
+        m_out.append(char(m_blockLen));
+        m_out.append(m_block, m_blockLen);
+        m_blockLen = 0;
+    }
+
+    QByteArray &m_out;
+    quint32 m_acc = 0;
+    int     m_bits = 0;
+    char    m_block[255];
+    int     m_blockLen = 0;
+};
+
+// --- GIF LZW compression of an Indexed8 image (row padding skipped).
+// Dictionary is an open-addressed hash of (prefixCode << 8 | nextIndex) -> code.
+static void lzwEncode(const QImage &indexed, int minCodeSize, QByteArray &out)
+{
+    constexpr int kMaxCode   = 4095;
+    constexpr int kHashSize  = 8192;             // power of two > 4096
+    constexpr int kHashMask  = kHashSize - 1;
+
+    QVector<qint32> keys(kHashSize, -1);
+    QVector<quint16> codes(kHashSize, 0);
+
+    const int clearCode = 1 << minCodeSize;
+    const int eoiCode   = clearCode + 1;
+    int codeSize = minCodeSize + 1;
+    int maxCode  = eoiCode;
+
+    out.append(char(minCodeSize));
+    LzwBitWriter bw(out);
+    bw.write(clearCode, codeSize);
+
+    const int w = indexed.width();
+    const int h = indexed.height();
+    int prefix = -1;
+
+    for (int y = 0; y < h; ++y) {
+        const uchar *row = indexed.constScanLine(y);
+        for (int x = 0; x < w; ++x) {
+            const int k = row[x];
+            if (prefix < 0) { prefix = k; continue; }
+
+            const qint32 key = (qint32(prefix) << 8) | k;
+            int slot = int((quint32(key) * 2654435761u) >> 19) & kHashMask;
+            bool found = false;
+            while (keys[slot] != -1) {
+                if (keys[slot] == key) { found = true; break; }
+                slot = (slot + 1) & kHashMask;
+            }
+            if (found) { prefix = codes[slot]; continue; }
+
+            bw.write(prefix, codeSize);
+
+            keys[slot]  = key;
+            codes[slot] = quint16(++maxCode);
+            if (maxCode >= (1 << codeSize)) ++codeSize;
+
+            if (maxCode == kMaxCode) {
+                // Dictionary full: emit clear and start over
+                bw.write(clearCode, codeSize);
+                keys.fill(-1);
+                codeSize = minCodeSize + 1;
+                maxCode  = eoiCode;
+            }
+            prefix = k;
+        }
+    }
+
+    if (prefix >= 0) bw.write(prefix, codeSize);
+    bw.write(eoiCode, codeSize);
+    bw.finish();
+}
+
+} // namespace
+
+GifEncoder::GifEncoder() = default;
+
+GifEncoder::~GifEncoder()
+{
+    cancel();
+}
+
+bool GifEncoder::writeBytes(const QByteArray &bytes, QString *errOut)
+{
+    if (!m_file || m_pending) {
+        if (errOut) *errOut = QStringLiteral("GIF encoder is not open.");
+        return false;
+    }
+    if (m_file->write(bytes) != bytes.size()) {
+        if (errOut) *errOut = QStringLiteral("Failed writing GIF: %1").arg(m_file->errorString());
+        return false;
+    }
+    m_bytes += bytes.size();
+    return true;
+}
+
+bool GifEncoder::open(const QString &outPath, const QSize &canvasSize, int loopCount, QString *errOut)
+{
+    cancel();
+
+    if (canvasSize.width() < 1 || canvasSize.height() < 1 ||
+        canvasSize.width() > 65535 || canvasSize.height() > 65535) {
+        if (errOut) *errOut = QStringLiteral("Invalid GIF canvas size.");
+        return false;
+    }
+
+    m_file = new QSaveFile(outPath);
+    if (!m_file->open(QIODevice::WriteOnly)) {
+        if (errOut) *errOut = QStringLiteral("Could not open %1 for writing: %2")
+                                  .arg(outPath, m_file->errorString());
+        delete m_file;
+        m_file = nullptr;
+        return false;
+    }
+    m_canvasSize = canvasSize;
+    m_frameCount = 0;
+    m_bytes      = 0;
+
+    QByteArray hdr;
+    hdr.append("GIF89a", 6);
+    // Logical screen descriptor: no global colour table, 8-bit colour resolution
+    putU16(hdr, canvasSize.width());
+    putU16(hdr, canvasSize.height());
+    hdr.append(char(0x70));
+    hdr.append(char(0));   // background colour index
+    hdr.append(char(0));   // pixel aspect ratio
+
+    if (loopCount >= 0) {
+        // NETSCAPE2.0 application extension (loop count, 0 = forever)
+        hdr.append(char(0x21)).append(char(0xFF)).append(char(11));
+        hdr.append("NETSCAPE2.0", 11);
+        hdr.append(char(3)).append(char(1));
+        putU16(hdr, qMin(loopCount, 65535));
+        hdr.append(char(0));
+    }
+    return writeBytes(hdr, errOut);
+}
+
+bool GifEncoder::addFrame(const QImage &frame, int delayCs, QString *errOut)
+{
+    return addFrame(frame, QPoint(0, 0), delayCs, DisposeBackground, errOut);
+}
+
+bool GifEncoder::addFrame(const QImage &frame, const QPoint &offset, int delayCs,
+                          Disposal disposal, QString *errOut)
+{
+    if (!m_file) {
+        if (errOut) *errOut = QStringLiteral("GIF encoder is not open.");
+        return false;
+    }
+    if (frame.isNull()) {
+        if (errOut) *errOut = QStringLiteral("Cannot encode an empty frame.");
+        return false;
+    }
+
+    const QImage indexed = (frame.format() == QImage::Format_Indexed8) ? frame : quantize(frame);
+    const QVector<QRgb> colors = indexed.colorTable();
+    if (colors.isEmpty() || colors.size() > 256) {
+        if (errOut) *errOut = QStringLiteral("GIF frames need a palette of 1..256 colours.");
+        return false;
+    }
+
+    int transparentIndex = -1;
+    for (int i = 0; i < colors.size(); ++i) {
+        if (qAlpha(colors[i]) == 0) { transparentIndex = i; break; }
+    }
+
+    // Palette size must be a power of two (2..256)
+    int tableBits = 1;
+    while ((1 << tableBits) < colors.size()) ++tableBits;
+    const int tableSize = 1 << tableBits;
+
+    QByteArray out;
+    out.reserve(indexed.width() * indexed.height() / 2 + tableSize * 3 + 64);
+
+    // Graphic control extension (delay, disposal, transparency)
+    out.append(char(0x21)).append(char(0xF9)).append(char(4));
+    out.append(char(((int(disposal) & 0x7) << 2) | (transparentIndex >= 0 ? 1 : 0)));
+    putU16(out, qBound(0, delayCs, 65535));
+    out.append(char(transparentIndex >= 0 ? transparentIndex : 0));
+    out.append(char(0));
+
+    // Image descriptor with local colour table
+    out.append(char(0x2C));
+    putU16(out, offset.x());
+    putU16(out, offset.y());
+    putU16(out, indexed.width());
+    putU16(out, indexed.height());
+    out.append(char(0x80 | (tableBits - 1)));
+
+    for (int i = 0; i < tableSize; ++i) {
+        const QRgb c = i < colors.size() ? colors[i] : 0;
+        out.append(char(qRed(c))).append(char(qGreen(c))).append(char(qBlue(c)));
+    }
+
+    lzwEncode(indexed, qMax(2, tableBits), out);
+
+    if (!writeBytes(out, errOut)) return false;
+    ++m_frameCount;
+    return true;
+}
+
+bool GifEncoder::close(QString *errOut)
+{
+    return closePending(errOut) && commit(errOut);
+}
+
+bool GifEncoder::closePending(QString *errOut)
+{
+    if (!m_file || m_pending) {
+        if (errOut) *errOut = QStringLiteral("GIF encoder is not open.");
+        return false;
+    }
+    if (m_frameCount == 0) {
+        if (errOut) *errOut = QStringLiteral("No frames were encoded.");
+        cancel();
+        return false;
+    }
+    if (!writeBytes(QByteArray(1, char(0x3B)), errOut)) { cancel(); return false; }
+    m_pending = true;
+    return true;
+}
+
+bool GifEncoder::commit(QString *errOut)
+{
+    if (!m_pending) {
+        if (errOut) *errOut = QStringLiteral("GIF encoder is not closed.");
+        return false;
+    }
+    const bool ok = m_file->commit();
+    if (!ok && errOut) *errOut = QStringLiteral("Failed to save GIF: %1").arg(m_file->errorString());
+    delete m_file;
+    m_file = nullptr;
+    m_pending = false;
+    return ok;
+}
+
+void GifEncoder::cancel()
+{
+    if (!m_file) return;
+    m_file->cancelWriting();
+    delete m_file;
+    m_file = nullptr;
+    m_frameCount = 0;
+    m_pending = false;
+}
+
+// Exact palette when the frame has <= 255 opaque colours, otherwise a
+// median-cut palette for this frame. One extra entry is reserved for transparency.
+QImage GifEncoder::quantize(const QImage &src)
+{
+    return ColorQuantizer::quantize(src);
+}
@@ -0,0 +1,83 @@
+#ifndef GIFENCODER_H
+#define GIFENCODER_H
+
+#include <QString>
+#include <QImage>
+#include <QSize>
+#include <QPoint>
+#include <QVector>
+#include <QByteArray>
+
+class QSaveFile;
+
+// Native GIF89a writer: frames go straight from memory into the output file,
+// no PNG round-trip and no external process.
+//
+// Usage:
+//   GifEncoder enc;
+//   enc.open(outPath, QSize(w, h), 0 /*loop forever*/, &err);
+//   enc.addFrame(img, delayCs, &err);   // repeat
+//   enc.close(&err);                    // writes trailer and commits the file
+//
+// The output is written through QSaveFile, so a failed or cancelled run never
+// leaves a truncated GIF behind.
+class GifEncoder
+{
+public:
+    // GIF disposal methods (what the decoder does with a frame before drawing the next one)
+    enum Disposal {
+        DisposeUnspecified = 0,
+        DisposeNone        = 1,   // leave the frame in place
+        DisposeBackground  = 2,   // clear the frame's rect to transparent
+        DisposePrevious    = 3    // restore what was there before the frame
+    };
+
+    GifEncoder();
+    ~GifEncoder();
+
+    GifEncoder(const GifEncoder &) = delete;
+    GifEncoder &operator=(const GifEncoder &) = delete;
+
+    // loopCount: 0 = loop forever (NETSCAPE2.0 extension), <0 = play once (no extension)
+    bool open(const QString &outPath, const QSize &canvasSize, int loopCount, QString *errOut);
+
+    // Full-canvas frame. Any format is accepted; Indexed8 images are written with their
+    // own colour table, everything else is quantized to <= 256 colours first.
+    bool addFrame(const QImage &frame, int delayCs, QString *errOut);
+
+    // Sub-rectangle frame placed at 'offset' on the logical screen.
+    bool addFrame(const QImage &frame, const QPoint &offset, int delayCs,
+                  Disposal disposal, QString *errOut);
+
+    // Writes the trailer and commits the file.
+    bool close(QString *errOut);
+
+    // close() in two steps, for several outputs that must appear together:
+    // closePending() writes the trailer but leaves the file uncommitted, then
+    // commit() puts it in place (or cancel() throws it away).
+    bool closePending(QString *errOut);
+    bool commit(QString *errOut);
+
+    // Discards everything written so far (the target file is left untouched).
+    void cancel();
+
+    bool  isOpen() const { return m_file != nullptr; }
+    QSize canvasSize() const { return m_canvasSize; }
+    int   frameCount() const { return m_frameCount; }
+    qint64 bytesWritten() const { return m_bytes; }
+
+    // Reduce an arbitrary image to an Indexed8 image with <= 256 colours.
+    // Pixels with alpha < 128 map to a transparent palette entry (alpha 0).
+    static QImage quantize(const QImage &src);
+
+private:
+    bool writeBytes(const QByteArray &bytes, QString *errOut);
+
+    QSaveFile *m_file = nullptr;
+    QSize      m_canvasSize;
+    int        m_frameCount = 0;
+    qint64     m_bytes = 0;
+    bool       m_pending = false;   // trailer written, waiting for commit()
+};
+
+#endif // GIFENCODER_H
@@ -0,0 +1,1534 @@
+#include "gifengine.h"
+#include "affinewarp.h"
+#include "framepipeline.h"
+#include "sphereprojection.h"
+#include "globescroll.h"
+#include "runprofile.h"
+#include "sourcecache.h"
+#include "texturesampler.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QPainter>
+#include <QRegularExpression>
+#include <QScopedPointer>
+#include <QSettings>
+#include <QThreadPool>
+#include <QTransform>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// --- Content detector shared by contentRect() and cropToOpaqueBounds().
+//     A pixel is content when its alpha is above 'threshold' (alpha mode), or
+//     when a colour channel differs from 'border' by more than 'threshold'
+//     (colour mode, alpha ignored). Rows are tested four pixels at a time.
+struct ContentTest {
+    bool    alpha;
+    quint32 border;
+    int     threshold;
+};
+
+static inline bool isContent(QRgb px, const ContentTest &t)
+{
+    if (t.alpha) return qAlpha(px) > t.threshold;
+    return std::abs(qRed(px)   - qRed(t.border))   > t.threshold ||
+           std::abs(qGreen(px) - qGreen(t.border)) > t.threshold ||
+           std::abs(qBlue(px)  - qBlue(t.border))  > t.threshold;
+}
+
+#if defined(__SSE2__)
+// Non-zero if any of the four pixels at 'px' is content
+static inline int contentMask4(const QRgb *px, const ContentTest &t)
+{
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(px));
+    if (t.alpha)
+        return _mm_movemask_epi8(_mm_cmpgt_epi32(_mm_srli_epi32(v, 24), _mm_set1_epi32(t.threshold)));
+    const __m128i border = _mm_set1_epi32(int(t.border));
+    const __m128i diff = _mm_or_si128(_mm_subs_epu8(v, border), _mm_subs_epu8(border, v));
+    const __m128i over = _mm_and_si128(_mm_subs_epu8(diff, _mm_set1_epi8(char(t.threshold))),
+                                       _mm_set1_epi32(0x00FFFFFF));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(over, _mm_setzero_si128())) ^ 0xFFFF;
+}
+#endif
+
+// First content pixel of row[from, to), or 'to'
+static int firstContent(const QRgb *row, int from, int to, const ContentTest &t)
+{
+    int x = from;
+#if defined(__SSE2__)
+    while (x + 4 <= to && !contentMask4(row + x, t)) x += 4;
+#endif
+    while (x < to && !isContent(row[x], t)) ++x;
+    return x;
+}
+
+// Last content pixel of row[from, to), or from - 1
+static int lastContent(const QRgb *row, int from, int to, const ContentTest &t)
+{
+    int x = to;
+#if defined(__SSE2__)
+    while (x - 4 >= from && !contentMask4(row + x - 4, t)) x -= 4;
+#endif
+    while (x > from && !isContent(row[x - 1], t)) --x;
+    return x - 1;
+}
+
+// Bounding box of the content of 'img' (32-bit), empty if there is none.
+// Each edge is only scanned as far in as its content starts: the rows above
+// and below, then per row the part left of / right of the bounds so far.
+static QRect contentBounds(const QImage &img, const ContentTest &t)
+{
+    const int w = img.width();
+    const int h = img.height();
+    auto row = [&](int y) { return reinterpret_cast<const QRgb *>(img.constScanLine(y)); };
+
+    int top = 0;
+    while (top < h && firstContent(row(top), 0, w, t) == w) ++top;
+    if (top == h) return QRect();
+    int bottom = h - 1;
+    while (bottom > top && firstContent(row(bottom), 0, w, t) == w) --bottom;
+
+    int left = w, right = -1;
+    for (int y = top; y <= bottom; ++y) {
+        const QRgb *r = row(y);
+        left  = qMin(left,  firstContent(r, 0, left, t));
+        right = qMax(right, lastContent(r, right + 1, w, t));
+    }
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+// --- Content bounds: without the transparent borders (alpha <= threshold)
+//     for images with alpha, otherwise without the rows/columns matching the
+//     top-left pixel colour. The whole image if there is nothing to trim.
+QRect GifEngine::contentRect(const QImage &src, int alphaThreshold)
+{
+    if (src.isNull()) return QRect();
+
+    const QImage::Format f = src.format();
+    const QImage img = (f == QImage::Format_ARGB32 || f == QImage::Format_ARGB32_Premultiplied ||
+                        f == QImage::Format_RGB32) ? src : src.convertToFormat(QImage::Format_ARGB32);
+
+    ContentTest test;
+    test.alpha     = src.hasAlphaChannel();
+    test.border    = img.pixel(0, 0);
+    test.threshold = test.alpha ? alphaThreshold : 2;   // colour tolerance
+
+    const QRect r = contentBounds(img, test);
+    return r.isEmpty() ? img.rect() : r;
+}
+
+// --- Trim borders (see contentRect)
+QImage GifEngine::cropToContentSmart(const QImage &src, int alphaThreshold)
+{
+    if (src.isNull()) return src;
+
+    const QImage img = src.convertToFormat(QImage::Format_ARGB32);
+    const QRect r = contentRect(src, alphaThreshold);
+    return r == img.rect() ? img : img.copy(r);
+}
+
+namespace {
+
+// --- NEW: find the bounding box of non-transparent pixels ---
+// Returns an empty QRect if the image is fully transparent or invalid.
+// alphaThreshold: treat pixels with alpha <= threshold as transparent (default 8).
+static QRect cropToOpaqueBounds(const QImage &img, int alphaThreshold = 8)
+{
+    if (img.isNull())
+        return QRect();
+
+    // If there’s no alpha channel, treat the whole image as opaque.
+    if (!img.hasAlphaChannel())
+        return QRect(0, 0, img.width(), img.height());
+
+    const QImage argb = img.format() == QImage::Format_ARGB32_Premultiplied
+                      ? img : img.convertToFormat(QImage::Format_ARGB32);
+    return contentBounds(argb, ContentTest { true, 0, alphaThreshold });
+}
+
+} // namespace
+
+GifEngine::GifEngine() = default;
+
+GifEngine::GifEngine(const Options &options)
+    : m_options(options)
+{
+}
+
+GifEngine::BacksideMode GifEngine::defaultBacksideMode()
+{
+    QSettings s("MyCompany", "GifMaker");
+    const int mode = s.value("backfaceMode", 0).toInt();
+    return (mode == BacksideNormal || mode == BacksideUpsideDown) ? BacksideMode(mode) : BacksideOff;
+}
+
+void GifEngine::log(const QString &msg) const
+{
+    if (m_logger) m_logger(msg);
+    else qDebug().noquote() << "[GIFStew]" << msg;
+}
+
+// Every pipeline a generator starts gets the engine's render/encode knobs
+void GifEngine::configure(FramePipeline &pipeline)
+{
+    m_lastFrameCount = 0;
+    pipeline.setWorkerCount(m_options.renderPool ? m_options.renderPool->maxThreadCount()
+                                                 : m_options.renderThreads);
+    pipeline.setThreadPool(m_options.renderPool);
+    pipeline.setPaletteMode(m_options.paletteMode);
+    pipeline.setOptimizeFrames(m_options.optimizeFrames);
+    pipeline.setCancelFlag(m_cancel);
+    pipeline.setProgress(m_progress);
+    pipeline.setFrameSink(m_sink);
+    pipeline.setProfile(m_profile);
+}
+
+// Sizes the run writes, largest (= rendered) first: 'sizePx' plus the
+// outputSizes option (not for a frame sink, which only wants 'sizePx')
+QList<int> GifEngine::runSizes(int sizePx) const
+{
+    QList<int> sizes { sizePx };
+    if (!m_sink) {
+        for (int px : m_options.outputSizes)
+            if (px > 0 && !sizes.contains(px)) sizes.append(px);
+    }
+    std::sort(sizes.begin(), sizes.end(), std::greater<int>());
+    return sizes;
+}
+
+int GifEngine::renderSizePx(int sizePx) const
+{
+    return runSizes(sizePx).first();
+}
+
+// configure() + start() on the rendered canvas, plus one extra output per
+// other size of the run, box-downscaled from the rendered frames. The file
+// for 'outSizePx' is outGifPath, the others sizedOutputPath() of it.
+bool GifEngine::startPipeline(FramePipeline &pipeline, const QString &outGifPath, int outSizePx,
+                              const QSize &canvasSize, int fps, QString *errOut)
+{
+    configure(pipeline);
+    const QList<int> sizes = runSizes(outSizePx);
+    const auto pathFor = [&](int px) {
+        return px == outSizePx ? outGifPath : sizedOutputPath(outGifPath, px);
+    };
+    if (!pipeline.start(pathFor(sizes.first()), canvasSize, fps, errOut)) return false;
+
+    for (int k = 1; k < sizes.size(); ++k) {
+        const QSize size(sizes[k], qMax(1, qRound(qreal(canvasSize.height()) * sizes[k] / canvasSize.width())));
+        if (!pipeline.addOutput(pathFor(sizes[k]), size, errOut)) {
+            pipeline.abort();
+            return false;
+        }
+    }
+    return true;
+}
+
+QString GifEngine::sizedOutputPath(const QString &outGifPath, int sizePx)
+{
+    const QFileInfo fi(outGifPath);
+    const QString suffix = fi.suffix().isEmpty() ? QStringLiteral("gif") : fi.suffix();
+    return fi.dir().filePath(QStringLiteral("%1_%2.%3").arg(fi.completeBaseName()).arg(sizePx).arg(suffix));
+}
+
+QList<int> GifEngine::parseSizeList(const QString &text, bool *ok)
+{
+    QList<int> sizes;
+    bool valid = true;
+    for (const QString &part : text.split(QRegularExpression("[,;\\s]+"), Qt::SkipEmptyParts)) {
+        bool isInt = false;
+        const int px = part.toInt(&isInt);
+        if (!isInt || px < 16 || px > 4096) { valid = false; continue; }
+        if (!sizes.contains(px)) sizes.append(px);
+    }
+    if (ok) *ok = valid;
+    return sizes;
+}
+
+// Crop-to-content looks for the borders on a decode this size (longest side)
+static constexpr int kCropProxyPx = 512;
+
+// --- Helper: decode 'path', only its 'clip' part (if valid), shrunk to fit
+//     'fitSize' (if valid and smaller). QImageReader hands both to the
+//     plugin, so a JPEG is scaled while decoding (DCT domain) and never held
+//     at camera resolution; other formats are scaled right after decoding.
+static QImage decodeFitted(const QString &path, const QSize &fitSize, const QRect &clip = QRect())
+{
+    QImageReader reader(path);
+    QSize size = reader.size();
+    if (!size.isValid()) {
+        // The format can't tell its size up front: decode, then trim and shrink
+        QImage img = reader.read();
+        if (clip.isValid()) img = img.copy(clip & img.rect());
+        if (fitSize.isValid() && !img.isNull() &&
+            (img.width() > fitSize.width() || img.height() > fitSize.height()))
+            img = img.scaled(fitSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        return img;
+    }
+
+    if (clip.isValid()) {
+        const QRect r = clip & QRect(QPoint(0, 0), size);
+        reader.setClipRect(r);
+        size = r.size();
+    }
+    if (fitSize.isValid() && (size.width() > fitSize.width() || size.height() > fitSize.height()))
+        reader.setScaledSize(size.scaled(fitSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1)));
+    return reader.read();
+}
+
+// --- Helper: SourceCache key of a loadImage() result
+static QString decodeKey(const QString &path, const QSize &fitSize, bool crop)
+{
+    QString key = SourceCache::fileKey(path);
+    if (key.isEmpty()) return key;
+    key += QStringLiteral("|decoded");
+    if (fitSize.isValid())
+        key += QStringLiteral("|fit %1x%2%3").arg(fitSize.width()).arg(fitSize.height())
+                                             .arg(crop ? QStringLiteral(" crop") : QString());
+    return key;
+}
+
+// Source images are decoded through here: once per file version and size
+// (see SourceCache), and timed in the profile.
+//
+// With a valid fitSize the image is decoded no larger than that, so memory
+// and time follow the output size rather than the camera's. 'crop' then
+// finds the content bounds (contentRect) on a small proxy first and decodes
+// only that region, so the content keeps its resolution once it is trimmed.
+// '*keyOut' gets the SourceCache key.
+QImage GifEngine::loadImage(const QString &path, const QSize &fitSize, bool crop, QString *keyOut) const
+{
+    const QString key = decodeKey(path, fitSize, crop);
+    if (keyOut) *keyOut = key;
+
+    RunProfile::Scope decode(m_profile, RunProfile::Decode);
+    qint64 bytes = 0;
+    const QImage img = SourceCache::get(key, [&] {
+        QRect clip;
+        const QSize full = QImageReader(path).size();
+        if (crop && fitSize.isValid() && full.isValid() &&
+            (full.width() > fitSize.width() || full.height() > fitSize.height())) {
+            // Coarse bounds on the proxy, padded by two proxy pixels; the exact
+            // trim runs later on the (small) decoded region
+            const QImage proxy = decodeFitted(path, QSize(kCropProxyPx, kCropProxyPx));
+            const QRect r = contentRect(proxy);
+            if (!r.isEmpty() && r != proxy.rect()) {
+                const qreal sx = qreal(full.width())  / proxy.width();
+                const qreal sy = qreal(full.height()) / proxy.height();
+                const QRect padded = r.adjusted(-2, -2, 2, 2);
+                clip = QRect(QPoint(qFloor(padded.left() * sx), qFloor(padded.top() * sy)),
+                             QPoint(qCeil((padded.right() + 1) * sx) - 1, qCeil((padded.bottom() + 1) * sy) - 1))
+                     & QRect(QPoint(0, 0), full);
+            }
+        }
+        QImage decoded = decodeFitted(path, fitSize, clip);
+        bytes = decoded.sizeInBytes();
+        return decoded;
+    });
+    decode.stop(bytes);
+    return img;
+}
+
+// Decoded, optionally cropped, then centred on a sizePx square of 'bg';
+// cached, so only the first run with these parameters pays for it
+QImage GifEngine::prepareCanvas(const QString &path, bool crop, int sizePx, const QColor &bg) const
+{
+    const QSize fit(sizePx, sizePx);
+    return prepareCanvas(SourceCache::fileKey(path), [&] { return loadImage(path, fit, crop); }, crop, sizePx, bg);
+}
+
+// Same for an image already in memory (the back face); 'sourceKey' is its
+// SourceCache key, 'load' runs only on a miss
+QImage GifEngine::prepareCanvas(const QString &sourceKey, const std::function<QImage()> &load,
+                                bool crop, int sizePx, const QColor &bg) const
+{
+    const QString key = sourceKey.isEmpty() ? QString()
+                      : sourceKey + QStringLiteral("|square|%1|%2|%3").arg(int(crop)).arg(sizePx).arg(bg.rgba());
+    return SourceCache::get(key, [&]() -> QImage {
+        QImage src = load();
+        if (src.isNull()) return src;
+        RunProfile::Scope canvas(m_profile, RunProfile::Canvas);
+        if (crop) src = cropToContentSmart(src);
+        const QImage square = makeSquareCanvas(src, sizePx, bg);
+        canvas.stop(square.sizeInBytes());
+        return square;
+    });
+}
+
+// Globe texture: decoded (no larger than 'fitSize'), ARGB32, zoomed (see
+// zoomImage); cached like prepareCanvas()
+QImage GifEngine::prepareTexture(const QString &path, const QSize &fitSize,
+                                 qreal zoomPercent, const QColor &padColor) const
+{
+    return prepareTexture(SourceCache::fileKey(path), [&] { return loadImage(path, fitSize); },
+                          fitSize, zoomPercent, padColor);
+}
+
+QImage GifEngine::prepareTexture(const QString &sourceKey, const std::function<QImage()> &load,
+                                 const QSize &fitSize, qreal zoomPercent, const QColor &padColor) const
+{
+    const QString key = sourceKey.isEmpty() ? QString()
+                      : sourceKey + QStringLiteral("|texture|%1|%2|%3").arg(fitSize.width())
+                                        .arg(qRound64(zoomPercent * 1000)).arg(padColor.rgba());
+    return SourceCache::get(key, [&]() -> QImage {
+        const QImage src = load();
+        if (src.isNull()) return src;
+        RunProfile::Scope canvas(m_profile, RunProfile::Canvas);
+        QImage texture = src.convertToFormat(QImage::Format_ARGB32);
+        if (qAbs(zoomPercent - 100.0) > 0.1)
+            texture = zoomImage(texture, zoomPercent, padColor);
+        canvas.stop(texture.sizeInBytes());
+        return texture;
+    });
+}
+
+// Square canvas of the run's back face (see resolveBackImage); null if single-sided
+QImage GifEngine::prepareBackCanvas(const QString &frontPath, bool crop, int sizePx, const QColor &bg) const
+{
+    QString key;
+    const QImage back = resolveBackImage(frontPath, &key, QSize(sizePx, sizePx), crop);
+    if (back.isNull()) return back;
+    return prepareCanvas(key, [&] { return back; }, crop, sizePx, bg);
+}
+
+bool GifEngine::finish(FramePipeline &pipeline, QString *errOut)
+{
+    const bool ok = pipeline.finish(errOut);
+    m_lastFrameCount = ok ? pipeline.framesEncoded() : 0;
+    return ok;
+}
+
+QImage GifEngine::resolveBackImage(const QString &frontPath, QString *keyOut,
+                                   const QSize &fitSize, bool crop) const
+{
+    QString simErr;
+    const bool wantSim = (m_options.backsideMode != BacksideOff);
+    const QImage back = ensureBackImageForRun(frontPath, m_options.backImagePath, wantSim, keyOut, &simErr,
+                                              fitSize, crop);
+    if (back.isNull() && !simErr.isEmpty()) {
+        log(wantSim ? QStringLiteral("Backside simulation failed: %1").arg(simErr) : simErr);
+        // continue single-sided if we must
+    }
+    return back;
+}
+
+// --- Helper: draw 'src' centered on a square canvas to prevent clipping when rotated
+QImage GifEngine::makeSquareCanvas(const QImage &src, int sizePx, const QColor &bg)
+{
+    QImage canvas(sizePx, sizePx, QImage::Format_ARGB32_Premultiplied);
+    canvas.fill(bg);
+    QPainter p(&canvas);
+    p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+    const QSize scaled = src.size().scaled(QSize(sizePx, sizePx), Qt::KeepAspectRatio);
+    const QPoint topLeft( (sizePx - scaled.width())/2, (sizePx - scaled.height())/2 );
+    p.drawImage(QRect(topLeft, scaled), src);
+    p.end();
+    return canvas;
+}
+
+// --- Helper: write frames as PNGs to framesDir (frame_0000.png, frame_0001.png, …)
+static bool writeFrames(const QList<QImage> &frames, const QString &framesDir, QString *errOut)
+{
+    QDir().mkpath(framesDir);
+    for (int i = 0; i < frames.size(); ++i) {
+        const QString fn = QString("%1/frame_%2.png")
+                               .arg(framesDir)
+                               .arg(i, 4, 10, QChar('0'));
+        if (!frames[i].save(fn, "PNG")) {
+            if (errOut) *errOut = QString("Failed saving %1").arg(fn);
+            return false;
+        }
+    }
+    return true;
+}
+
+// --- Helper: key for a rendered pose (face + transform parameters). Frames
+//     with equal keys look the same, so FramePipeline renders them only once.
+static QString poseKey(const QImage &face, qreal a, qreal b = 0.0, qreal c = 0.0)
+{
+    return QStringLiteral("%1/%2/%3/%4")
+        .arg(face.cacheKey())
+        .arg(qRound64(a * 1e6))
+        .arg(qRound64(b * 1e6))
+        .arg(qRound64(c * 1e6));
+}
+
+// --- Helper: angle wrapped into [0, period)
+static qreal wrapDegrees(qreal deg, qreal period = 360.0)
+{
+    qreal a = std::fmod(deg, period);
+    if (a < 0) a += period;
+    return a;
+}
+
+// --- Helper: loop period of a run whose motions each advance a fixed part of
+//     their cycle per frame ('turnsPerFrame': 1 = a full cycle every frame).
+//     Frame i and frame i + period look the same; the result is the least
+//     common multiple of the motions' periods, or totalFrames when they do
+//     not repeat within the run. No motions: every frame is the same (1).
+static int loopPeriod(const QVector<qreal> &turnsPerFrame, int totalFrames)
+{
+    qint64 period = 1;
+    for (const qreal rate : turnsPerFrame) {
+        int p = 0;
+        for (int n = 1; n <= totalFrames && !p; ++n) {
+            const qreal turns = rate * n;
+            if (std::abs(turns - std::round(turns)) < 1e-6) p = n;   // < 0.0004 degrees off
+        }
+        if (!p) return totalFrames;
+        period = period / std::gcd(period, qint64(p)) * p;
+        if (period >= totalFrames) return totalFrames;
+    }
+    return int(period);
+}
+
+// --- Helper: frames to actually write for a run of 'totalFrames' that repeats
+//     every 'period'. The GIF loops forever, so when the run is a whole number
+//     of periods one period plays back exactly the same; otherwise the run
+//     keeps its length (and its seam) and only the rendering repeats.
+static int framesToWrite(int period, int totalFrames)
+{
+    return (period > 0 && totalFrames % period == 0) ? period : totalFrames;
+}
+
+// Decide if we’re seeing the back for a given rotation angle.
+// Back is visible when cosine is negative -> angle in (90°, 270°)
+static inline bool isBackVisible(qreal angleDeg)
+{
+    qreal a = std::fmod(angleDeg, 360.0);
+    if (a < 0) a += 360.0;
+    return (a > 90.0 && a < 270.0);
+}
+
+// Resolve front & back QImages for this run (will auto-simulate the back if enabled or missing).
+bool GifEngine::resolveFrontBackImages(const QString &frontPath,
+                                        const QString &maybeBackPath,
+                                        QImage &frontOut,
+                                        QImage &backOut,
+                                        QString *errOut)
+{
+    if (frontPath.isEmpty()) {
+        if (errOut) *errOut = tr("No front image selected.");
+        return false;
+    }
+
+    QImage front = loadImage(frontPath);
+    if (front.isNull()) {
+        if (errOut) *errOut = tr("Failed to load front image: %1").arg(frontPath);
+        return false;
+    }
+
+    const bool simulateBack = (m_options.backsideMode != BacksideOff);
+    QImage back = ensureBackImageForRun(frontPath, maybeBackPath, simulateBack, nullptr, errOut);
+
+    // If we didn’t get a back image (either not provided or simulation failed),
+    // fall back to single-sided rendering by using the front as the back.
+    // This keeps animations working instead of hard-failing.
+    if (back.isNull())
+        back = front;
+
+    // Normalize sizes so face swaps don’t “jump”
+    if (back.size() != front.size()) {
+        RunProfile::Scope canvas(m_profile, RunProfile::Canvas);
+        back = back.scaled(front.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        canvas.stop(back.sizeInBytes());
+    }
+
+    frontOut = std::move(front);
+    backOut  = std::move(back);
+    return true;
+}
+
+// Pick which face to use at a given angle (works for both yaw-spin and pitch-flip).
+const QImage &GifEngine::pickFaceForAngle(const QImage &front,
+                                           const QImage &back,
+                                           qreal angleDeg) const
+{
+    return isBackVisible(angleDeg) ? back : front;
+}
+
+// Main globe generation function with backside and rotation axis support
+QImage GifEngine::renderGlobeFrame(const QImage &frontTexture,
+                                   const QImage &backTexture,
+                                   qreal rotationDegrees,
+                                   int sizePx,
+                                   const QColor &frameBg,
+                                   const QColor &globeSurfaceColor,
+                                   bool enableLighting,
+                                   int rotationAxis)
+{
+    const TextureSampler sampler(frontTexture, backTexture, globeSurfaceColor);
+    return renderGlobeFrame(sampler, rotationDegrees, sizePx, frameBg, enableLighting, rotationAxis);
+}
+
+QImage GifEngine::renderGlobeFrame(const TextureSampler &sampler,
+                                   qreal rotationDegrees,
+                                   int sizePx,
+                                   const QColor &frameBg,
+                                   bool enableLighting,
+                                   int rotationAxis)
+{
+    QImage frame(sizePx, sizePx, QImage::Format_ARGB32_Premultiplied);
+    frame.fill(frameBg);  // Fill canvas with transparent (or chosen frame color)
+    drawGlobeFrame(frame, sampler, rotationDegrees, enableLighting, rotationAxis);
+    return frame;
+}
+
+void GifEngine::drawGlobeFrame(QImage &frame,
+                               const TextureSampler &sampler,
+                               qreal rotationDegrees,
+                               bool enableLighting,
+                               int rotationAxis)
+{
+    if (sampler.isNull()) return;
+    const int sizePx = frame.width();
+
+    // Disc mask + normals are the same for every frame of this size
+    const QSharedPointer<const SphereProjection> proj = SphereProjection::forSize(sizePx);
+
+    // Rotation is constant for the whole frame
+    const qreal rotRad = qDegreesToRadians(rotationDegrees);
+    const qreal cosR   = qCos(rotRad);
+    const qreal sinR   = qSin(rotRad);
+    const qreal cosR2  = qCos(rotRad * 0.5);
+    const qreal sinR2  = qSin(rotRad * 0.5);
+
+    // Per-row texture coordinates, sampled a whole row at a time
+    QVector<quint32> lonRow(sizePx), yFrontRow(sizePx), yBackRow(sizePx);
+    QVector<qreal>   nzRow(sizePx);
+
+    // Render sphere using orthographic projection
+    for (int py = 0; py < sizePx; ++py) {
+        const SphereProjection::Row &row = proj->rows[py];
+        QRgb *dst = reinterpret_cast<QRgb *>(frame.scanLine(py)) + row.x0;
+
+        for (int k = 0; k < row.count; ++k) {
+            qreal nx = proj->nx[row.offset + k];
+            qreal ny = proj->ny[row.offset + k];
+            qreal nz = proj->nz[row.offset + k];
+
+            // Apply rotation based on axis
+            if (rotationAxis == 0) {
+                const qreal newNx = nx * cosR - nz * sinR;
+                const qreal newNz = nx * sinR + nz * cosR;
+                nx = newNx;
+                nz = newNz;
+            }
+            else if (rotationAxis == 1) {
+                const qreal newNy = ny * cosR - nz * sinR;
+                const qreal newNz = ny * sinR + nz * cosR;
+                ny = newNy;
+                nz = newNz;
+            }
+            else if (rotationAxis == 2) {
+                qreal newNx = nx * cosR - nz * sinR;
+                qreal newNz = nx * sinR + nz * cosR;
+
+                const qreal newNy = ny * cosR2 - newNz * sinR2;
+                newNz = ny * sinR2 + newNz * cosR2;
+
+                nx = newNx;
+                ny = newNy;
+                nz = newNz;
+            }
+
+            const qreal lat = qAsin(qBound<qreal>(-1.0, ny, 1.0));
+            const qreal lon = qAtan2(nx, nz);
+
+            lonRow[k]    = TextureSampler::turnsFor(lon);
+            yFrontRow[k] = TextureSampler::rowFor(lat, sampler.frontHeight());
+            yBackRow[k]  = TextureSampler::rowFor(lat, sampler.backHeight());
+            nzRow[k]     = nz;
+        }
+
+        // Sample texture - globeSurfaceColor for areas without texture
+        sampler.sampleRow(lonRow.constData(), yFrontRow.constData(), yBackRow.constData(),
+                          dst, row.count);
+
+        // Apply lighting (preserve alpha channel!)
+        if (enableLighting) {
+            for (int k = 0; k < row.count; ++k) {
+                // Symmetric + slightly brighter floor so the back isn't greyed out
+                const qreal lightDot = nzRow[k];
+                const qreal brightness = qBound(0.75, qAbs(lightDot), 1.0);
+
+                const QRgb texColor = dst[k];
+                const int r = qRound(qRed(texColor)   * brightness);
+                const int g = qRound(qGreen(texColor) * brightness);
+                const int b = qRound(qBlue(texColor)  * brightness);
+                const int a = qAlpha(texColor); // PRESERVE alpha
+                dst[k] = qRgba(r, g, b, a);
+            }
+        }
+    }
+}
+
+// Simple L/R spin (yaw) with backside support.
+// Arguments you likely already pass in elsewhere:
+//  - frontPath, backPath: user-chosen paths (back may be empty)
+//  - outDir: where to write frames/GIF (this uses writeFrames on framesDir)
+//  - fps, durationSec: timing
+//  - maxAngleDeg: half-rotation amplitude (e.g., 180 for full spin, 90 for sway)
+//  - cycles: how many full cycles to perform
+bool GifEngine::generateSpinGif(const QString &frontPath,
+                                 const QString &backPath,
+                                 const QString &outDir,
+                                 int fps,
+                                 int durationSec,
+                                 qreal maxAngleDeg,
+                                 int cycles,
+                                 QString *errOut)
+{
+    QImage front, back;
+    if (!resolveFrontBackImages(frontPath, backPath, front, back, errOut))
+        return false;
+
+    const int totalFrames = qMax(1, fps * durationSec);
+    QList<QImage> frames;
+    frames.reserve(totalFrames);
+
+    // Base canvas: keep output size consistent
+    const QSize canvasSize = front.size();
+
+    // We'll sweep angle over cycles using a sine wave for smooth looping
+    // t in [0,1) -> angle = sin(t * 2π * cycles) * maxAngleDeg
+    RunProfile::Scope render(m_profile, RunProfile::Render);
+    for (int i = 0; i < totalFrames; ++i) {
+        const qreal t = static_cast<qreal>(i) / totalFrames;
+        const qreal angle = std::sin(t * 2.0 * M_PI * cycles) * maxAngleDeg;
+
+        // Choose which face to show at this yaw
+        const QImage &src = pickFaceForAngle(front, back, angle);
+
+        // Horizontal squash to fake perspective: scale factor ~ |cos(angle)|
+        const qreal cosA = std::abs(std::cos(qDegreesToRadians(angle)));
+        const int w = qMax(1, int(canvasSize.width() * cosA));
+        const int h = canvasSize.height();
+
+        QImage frame(canvasSize, QImage::Format_ARGB32_Premultiplied);
+        frame.fill(Qt::transparent);
+
+        QPainter p(&frame);
+        p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+
+        // Optionally add a subtle vertical scale for depth feeling
+        const qreal yScale = 0.98 + 0.02 * cosA; // ~1.0 at face-on, ~0.98 at edge-on
+        const int targetH = int(h * yScale);
+
+        // Center the squashed face on canvas
+        QRect target((canvasSize.width() - w) / 2,
+                     (canvasSize.height() - targetH) / 2,
+                     w, targetH);
+
+        p.drawImage(target, src);
+        p.end();
+
+        frames.push_back(std::move(frame));
+    }
+    render.stop(qint64(frames.size()) * canvasSize.width() * canvasSize.height() * 4);
+
+    // Write frames (your existing helper)
+    const QString framesDir = outDir; // If you use a subdir, adjust here
+    RunProfile::Scope encode(m_profile, RunProfile::Encode);
+    if (!writeFrames(frames, framesDir, errOut)) {
+        if (errOut && errOut->isEmpty())
+            *errOut = tr("Failed writing spin frames.");
+        return false;
+    }
+    return true;
+}
+
+// U/D flip (pitch) with backside support.
+// Similar parameters to generateSpinGif; flip amplitude is maxAngleDeg (e.g., 180 for full flips).
+bool GifEngine::generateFlipGif(const QString &frontPath,
+                                 const QString &backPath,
+                                 const QString &outDir,
+                                 int fps,
+                                 int durationSec,
+                                 qreal maxAngleDeg,
+                                 int cycles,
+                                 QString *errOut)
+{
+    QImage front, back;
+    if (!resolveFrontBackImages(frontPath, backPath, front, back, errOut))
+        return false;
+
+    const int totalFrames = qMax(1, fps * durationSec);
+    QList<QImage> frames;
+    frames.reserve(totalFrames);
+
+    const QSize canvasSize = front.size();
+
+    RunProfile::Scope render(m_profile, RunProfile::Render);
+    for (int i = 0; i < totalFrames; ++i) {
+        const qreal t = static_cast<qreal>(i) / totalFrames;
+        const qreal angle = std::sin(t * 2.0 * M_PI * cycles) * maxAngleDeg;
+
+        // Choose which face to show at this pitch
+        const QImage &src = pickFaceForAngle(front, back, angle);
+
+        // Vertical squash ~ |cos(angle)|
+        const qreal cosA = std::abs(std::cos(qDegreesToRadians(angle)));
+        const int w = canvasSize.width();
+        const int h = qMax(1, int(canvasSize.height() * cosA));
+
+        QImage frame(canvasSize, QImage::Format_ARGB32_Premultiplied);
+        frame.fill(Qt::transparent);
+
+        QPainter p(&frame);
+        p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+
+        // Optional slight x-scale for depth feeling
+        const qreal xScale = 0.98 + 0.02 * cosA;
+        const int targetW = int(w * xScale);
+
+        QRect target((canvasSize.width() - targetW) / 2,
+                     (canvasSize.height() - h) / 2,
+                     targetW, h);
+
+        p.drawImage(target, src);
+        p.end();
+
+        frames.push_back(std::move(frame));
+    }
+    render.stop(qint64(frames.size()) * canvasSize.width() * canvasSize.height() * 4);
+
+    const QString framesDir = outDir;
+    RunProfile::Scope encode(m_profile, RunProfile::Encode);
+    if (!writeFrames(frames, framesDir, errOut)) {
+        if (errOut && errOut->isEmpty())
+            *errOut = tr("Failed writing flip frames.");
+        return false;
+    }
+    return true;
+}
+
+// --- Backside kernel: mirror + desaturate (sat 0.85) + dim (0.90) in one
+//     pass, 8-bit fixed point. dim * (gray + sat * (c - gray)) folds into
+//     0.765 c + 0.135 gray; the weights are /256 and truncate like the old
+//     float code did (within one level of it). Linear, so premultiplied
+//     pixels can be mixed as they are; alpha is kept.
+static constexpr int kGrayR = 77, kGrayG = 150, kGrayB = 29;   // 0.299 / 0.587 / 0.114
+static constexpr int kKeep = 196, kMix = 34;                   // 0.765 / 0.135
+
+static inline QRgb backsidePixel(QRgb px)
+{
+    const int r = qRed(px), g = qGreen(px), b = qBlue(px);
+    const int mix = kMix * ((kGrayR * r + kGrayG * g + kGrayB * b) >> 8);
+    return qRgba((kKeep * r + mix) >> 8, (kKeep * g + mix) >> 8, (kKeep * b + mix) >> 8, qAlpha(px));
+}
+
+#if defined(__SSE2__)
+// Two pixels as 16-bit channels (b, g, r, a)
+static inline __m128i backsideMix(__m128i px)
+{
+    const __m128i grayW = _mm_setr_epi16(kGrayB, kGrayG, kGrayR, 0, kGrayB, kGrayG, kGrayR, 0);
+    __m128i sums = _mm_madd_epi16(px, grayW);                        // bg0, r0, bg1, r1
+    sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(2, 3, 0, 1)));
+    __m128i gray = _mm_packs_epi32(_mm_srli_epi32(sums, 8), sums);   // g0 g0 g1 g1 ...
+    gray = _mm_unpacklo_epi32(gray, gray);                           // g0 x4, g1 x4
+    return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(px, _mm_set1_epi16(kKeep)),
+                                        _mm_mullo_epi16(gray, _mm_set1_epi16(kMix))), 8);
+}
+#endif
+
+// One row: dst[x] = kernel(src[width - 1 - x])
+static void backsideRow(const QRgb *src, QRgb *dst, int width)
+{
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi32(int(0xFF000000u));
+    for (; x + 4 <= width; x += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + width - x - 4));
+        px = _mm_shuffle_epi32(px, _MM_SHUFFLE(0, 1, 2, 3));          // mirror
+        const __m128i out = _mm_packus_epi16(backsideMix(_mm_unpacklo_epi8(px, zero)),
+                                             backsideMix(_mm_unpackhi_epi8(px, zero)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x),
+                         _mm_or_si128(_mm_andnot_si128(alpha, out), _mm_and_si128(alpha, px)));
+    }
+#endif
+    for (; x < width; ++x)
+        dst[x] = backsidePixel(src[width - 1 - x]);
+}
+
+// Mirrored horizontally (like viewing the back of a sticker), a little less
+// colourful and a little darker
+QImage GifEngine::makeBacksideFrom(const QImage &front, bool *ok, QString *errOut)
+{
+    if (ok) *ok = false;
+    if (front.isNull()) {
+        if (errOut) *errOut = QStringLiteral("Front image is empty.");
+        return {};
+    }
+
+    const QImage base = front.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QImage back(base.size(), QImage::Format_ARGB32_Premultiplied);
+    if (back.isNull()) {
+        if (errOut) *errOut = QStringLiteral("Out of memory for the backside.");
+        return {};
+    }
+
+    const int w = base.width();
+    for (int y = 0; y < base.height(); ++y)
+        backsideRow(reinterpret_cast<const QRgb *>(base.constScanLine(y)),
+                    reinterpret_cast<QRgb *>(back.scanLine(y)), w);
+
+    if (ok) *ok = true;
+    return back;
+}
+
+// The back stays in memory: the explicit back decoded through loadImage(),
+// or the simulated one cached next to the front's decode. fitSize / crop
+// are passed on to loadImage() (the simulated back mirrors that decode).
+QImage GifEngine::ensureBackImageForRun(const QString &frontPath,
+                                        const QString &explicitBackPath,
+                                        bool simulateBack,
+                                        QString *keyOut,
+                                        QString *errOut,
+                                        const QSize &fitSize,
+                                        bool crop) const
+{
+    if (keyOut) keyOut->clear();
+
+    // If user supplied a back image and we’re not forcing simulation, use it
+    if (!explicitBackPath.trimmed().isEmpty() && !simulateBack) {
+        if (!QFileInfo::exists(explicitBackPath)) {
+            if (errOut) *errOut = QStringLiteral("Back image does not exist: %1").arg(explicitBackPath);
+            return {};
+        }
+        QString key;
+        const QImage back = loadImage(explicitBackPath, fitSize, crop, &key);
+        if (back.isNull()) {
+            if (errOut) *errOut = QStringLiteral("Failed to load back image: %1").arg(explicitBackPath);
+            return {};
+        }
+        if (keyOut) *keyOut = key;
+        return back;
+    }
+
+    if (!simulateBack) {
+        return {}; // single-sided
+    }
+
+    if (frontPath.trimmed().isEmpty() || !QFileInfo::exists(frontPath)) {
+        if (errOut) *errOut = QStringLiteral("Front image not set or missing; cannot simulate backside.");
+        return {};
+    }
+
+    const QString key = decodeKey(frontPath, fitSize, crop) + QStringLiteral("|backside");
+    QString mkErr;
+    const QImage back = SourceCache::get(key, [&]() -> QImage {
+        const QImage front = loadImage(frontPath, fitSize, crop);
+        RunProfile::Scope backside(m_profile, RunProfile::Backside);
+        bool ok = false;
+        const QImage img = makeBacksideFrom(front, &ok, &mkErr);
+        backside.stop(img.sizeInBytes());
+        return ok ? img : QImage();
+    });
+    if (back.isNull()) {
+        if (errOut) *errOut = mkErr.isEmpty() ? QStringLiteral("Failed to generate backside.") : mkErr;
+        return {};
+    }
+    if (keyOut) *keyOut = key;
+    return back;
+}
+
+
+// --- Main worker: spin (full 360°) over 'durationSec' at 'fps', output GIF.
+//    - srcImagePath: input still image
+//    - outGifPath:   absolute path to animated GIF
+//    - fps:          frames per second (e.g. 12, 24)
+//    - durationSec:  total duration (e.g. 2 → 2 seconds)
+//    - sizePx:       canvas size (square); image keeps aspect and is centered
+//    - bg:           background color (use Qt::transparent for alpha, or a solid color)
+// Returns true on success; on failure returns false and sets *errOut.
+bool GifEngine::generateSpinGif(const QString &srcImagePath,
+                                 const QString &outGifPath,
+                                 int fps,
+                                 qreal durationSec,
+                                 int sizePx,
+                                 const QColor &bg,
+                                 QString *errOut)
+{
+    if (!QFileInfo::exists(srcImagePath)) { if (errOut) *errOut="Source image does not exist."; return false; }
+    if (fps <= 0 || durationSec <= 0)     { if (errOut) *errOut="FPS and duration must be > 0."; return false; }
+
+    if (sizePx < 32) sizePx = qMax(32, sizePx);
+    const int outSizePx = sizePx;
+    sizePx = renderSizePx(outSizePx);
+    const QImage frontBase = prepareCanvas(srcImagePath, false, sizePx, bg);
+    if (frontBase.isNull()) { if (errOut) *errOut="Failed to load source image."; return false; }
+
+    // Explicit or auto-simulated back face, if any
+    const QImage backCanvas = prepareBackCanvas(srcImagePath, false, sizePx, bg);
+    const bool haveBack = !backCanvas.isNull();
+    const QImage backBase = haveBack ? backCanvas : frontBase;
+
+    const QSize canvasSize = frontBase.size();
+    const int totalFrames = frameCount(fps, durationSec);
+    FramePipeline pipeline;
+    if (!startPipeline(pipeline, outGifPath, outSizePx, canvasSize, fps, errOut)) return false;
+
+    RunProfile::Scope canvas(m_profile, RunProfile::Canvas);
+    const AffineWarp frontWarp(frontBase);
+    const AffineWarp backWarp(backBase);
+    canvas.stop();
+
+    // Yaw spin: we sweep 0..360 degrees. When cos < 0, show the backside.
+    // Horizontal scale ~ |cos| with an epsilon so it never vanishes.
+    const qreal eps = 0.08;
+
+    // Only the face and |cos| matter: phi and 360-phi give the same frame
+    const auto poseOf = [&](int i) -> QString {
+        const qreal c = qCos(qDegreesToRadians(360.0 * i / totalFrames));
+        return poseKey(c < 0.0 ? backBase : frontBase, std::abs(c));
+    };
+
+    pipeline.renderFrames(totalFrames, poseOf, [&](int i) -> QImage {
+        const qreal t   = (qreal)i / (qreal)totalFrames;
+        const qreal deg = 360.0 * t;
+        const qreal rad = qDegreesToRadians(deg);
+        const qreal c   = qCos(rad);
+
+        const bool showBack = (c < 0.0);
+        const qreal sxAbs   = (1.0 - eps) * std::abs(c) + eps; // width “thickness”
+
+        const AffineWarp &face = showBack ? backWarp : frontWarp;
+
+        // Optional slight vertical scale for depth feel near edge-on
+        const qreal yScale = 0.98 + 0.02 * std::abs(c);
+        const int targetW  = qMax(1, int(canvasSize.width() * sxAbs));
+        const int targetH  = qMax(1, int(canvasSize.height() * yScale));
+
+        const QRect target((canvasSize.width()  - targetW)/2,
+                           (canvasSize.height() - targetH)/2,
+                           targetW, targetH);
+
+        QImage frame = pipeline.framePool().acquire(bg, face.bounds(target));
+        face.draw(frame, target);
+        return frame;
+    });
+
+    return finish(pipeline, errOut);
+}
+
+// --- Variation: rotate back-and-forth (oscillate) by +/-maxDegrees
+bool GifEngine::generateOscillateGif(const QString &srcImagePath,
+                                      const QString &outGifPath,
+                                      int fps,
+                                      qreal durationSec,
+                                      int sizePx,
+                                      qreal maxDegrees,
+                                      const QColor &bg,
+                                      QString *errOut)
+{
+    if (!QFileInfo::exists(srcImagePath)) { if (errOut) *errOut="Source image does not exist."; return false; }
+    if (fps <= 0 || durationSec <= 0)     { if (errOut) *errOut="FPS and duration must be > 0."; return false; }
+
+    const int outSizePx = qMax(32, sizePx);
+    sizePx = renderSizePx(outSizePx);
+    const QImage base = prepareCanvas(srcImagePath, false, sizePx, bg);
+    if (base.isNull()) { if (errOut) *errOut="Failed to load source image."; return false; }
+
+    const int totalFrames = frameCount(fps, durationSec);
+    const QPointF center(base.width()/2.0, base.height()/2.0);
+    RunProfile::Scope canvas(m_profile, RunProfile::Canvas);
+    const AffineWarp warp(base);
+    canvas.stop();
+
+    FramePipeline pipeline;
+    if (!startPipeline(pipeline, outGifPath, outSizePx, base.size(), fps, errOut)) return false;
+
+    // The sine sweep passes every angle twice per period
+    const auto poseOf = [&](int i) -> QString {
+        return poseKey(base, maxDegrees * qSin(2.0 * M_PI * i / totalFrames));
+    };
+
+    pipeline.renderFrames(totalFrames, poseOf, [&](int i) -> QImage {
+        const qreal t   = (qreal)i / (qreal)totalFrames;
+        const qreal deg = maxDegrees * qSin(2.0*M_PI*t);
+
+        QTransform tr;                     // ← clean start
+        tr.translate(center.x(), center.y());
+        tr.rotate(deg);                    // ← only Z rotation, no shear
+        tr.translate(-center.x(), -center.y());
+
+        QImage frame = pipeline.framePool().acquire(bg, warp.bounds(tr));
+        warp.draw(frame, tr);
+        return frame;
+    });
+
+    return finish(pipeline, errOut);
+}
+
+bool GifEngine::generateYawSpinGif(const QString &frontImagePath,
+                                    const QString &outGifPath,
+                                    int fps,
+                                    qreal durationSec,
+                                    int sizePx,
+                                    qreal rotations,          // interpreted as # of full rotations
+                                    const QColor &bg,
+                                    QString *errOut)
+{
+    const QString backImagePath = m_options.backImagePath;
+    const bool cropContent      = m_options.cropToContent;
+
+    // Validate
+    if (!QFileInfo::exists(frontImagePath)) { if (errOut) *errOut = "Front image does not exist."; return false; }
+    if (fps <= 0 || durationSec <= 0)       { if (errOut) *errOut = "FPS and duration must be > 0."; return false; }
+    if (sizePx < 32) sizePx = 256;
+    const int outSizePx = sizePx;
+    sizePx = renderSizePx(outSizePx);
+    if (rotations < 0) rotations = 0;
+
+    // Load, optionally crop to content, square-pad to size with bg (keeping aspect)
+    const QImage frontBase = prepareCanvas(frontImagePath, cropContent, sizePx, bg);
+    if (frontBase.isNull()) { if (errOut) *errOut = "Failed to load front image."; return false; }
+
+    const QImage backCanvas = backImagePath.isEmpty() ? QImage()
+                                                      : prepareCanvas(backImagePath, cropContent, sizePx, bg);
+    const bool haveBack = !backCanvas.isNull();
+    const QImage backBase = haveBack ? backCanvas : frontBase;
+
+    const int totalFrames = frameCount(fps, durationSec);
+    if (totalFrames < 1) { if (errOut) *errOut = "Total frames computed < 1."; return false; }
+
+    const QPointF center(frontBase.width()/2.0, frontBase.height()/2.0);
+    RunProfile::Scope canvas(m_profile, RunProfile::Canvas);
+    const AffineWarp frontWarp(frontBase);
+    const AffineWarp backWarp(backBase);
+    canvas.stop();
+
+    // Several rotations: one of them loops just the same
+    const int period = loopPeriod({ rotations / totalFrames }, totalFrames);
+
+    FramePipeline pipeline;
+    if (!startPipeline(pipeline, outGifPath, outSizePx, frontBase.size(), fps, errOut)) return false;
+    const qreal eps = 0.08;
+
+    // Only the face and |cos| matter: phi and 360-phi give the same frame
+    const auto poseOf = [&](int i) -> QString {
+        const qreal c = qCos(qDegreesToRadians(rotations * 360.0 * (i % period) / totalFrames));
+        return poseKey(c < 0.0 ? backBase : frontBase, std::abs(c));
+    };
+
+    pipeline.renderFrames(framesToWrite(period, totalFrames), poseOf, [&](int i) -> QImage {
+        const qreal t      = (qreal)(i % period) / (qreal)totalFrames;
+        const qreal phiDeg = rotations * 360.0 * t;
+        const qreal c      = qCos(qDegreesToRadians(phiDeg));
+
+        const bool showBack = (c < 0.0);
+        const qreal sxAbs   = (1.0 - eps) * std::abs(c) + eps;
+        const AffineWarp &face = showBack ? backWarp : frontWarp;
+
+        QTransform tr;
+        tr.translate(center.x(), center.y());
+        tr.scale(sxAbs, 1.0);   // no shear → no tilt
+        tr.translate(-center.x(), -center.y());
+
+        QImage frame = pipeline.framePool().acquire(bg, face.bounds(tr));
+        face.draw(frame, tr);
+        return frame;
+    });
+
+    return finish(pipeline, errOut);
+}
+
+bool GifEngine::generateFlipGif(const QString &frontImagePath,
+                                 const QString &outGifPath,
+                                 int fps,
+                                 qreal durationSec,
+                                 int sizePx,
+                                 bool animate,
+                                 int cycles,
+                                 const QColor &bg,
+                                 QString *errOut)
+{
+    if (!QFileInfo::exists(frontImagePath)) { if (errOut) *errOut="Front image does not exist."; return false; }
+    if (fps <= 0 || durationSec <= 0)       { if (errOut) *errOut="FPS and duration must be > 0."; return false; }
+    if (sizePx < 32) sizePx = 256;
+    const int outSizePx = sizePx;
+    sizePx = renderSizePx(outSizePx);
+
+    // Square canvases; the back is explicit or auto-simulated (toggle ON)
+    const QImage frontBase = prepareCanvas(frontImagePath, false, sizePx, bg);
+    if (frontBase.isNull()) { if (errOut) *errOut="Failed to load front image."; return false; }
+
+    const QImage backCanvas = prepareBackCanvas(frontImagePath, false, sizePx, bg);
+    const bool haveBack = !backCanvas.isNull();
+    const QImage backBase = haveBack ? backCanvas : frontBase;
+
+    // Should the *flip* show the backside upside down?
+    const bool upsideDown = (m_options.backsideMode == BacksideUpsideDown);
+    RunProfile::Scope canvas(m_profile, RunProfile::Canvas);
+    const QImage backForFlip = upsideDown ? backBase.mirrored(true, true) : backBase;
+    canvas.stop(upsideDown ? backForFlip.sizeInBytes() : 0);
+
+    const QPointF center(frontBase.width()/2.0, frontBase.height()/2.0);
+    const QRectF  dst(0.0, 0.0, frontBase.width(), frontBase.height());
+
+    // Non-animated “flip”: just show back (respecting upside-down if selected), else front
+    if (!animate) {
+        const QImage &face = haveBack ? backForFlip : frontBase;
+
+        QImage frame(frontBase.size(), QImage::Format_ARGB32_Premultiplied);
+        frame.fill(bg);
+        QPainter p(&frame);
+        p.setRenderHint(QPainter::SmoothPixmapTransform,true);
+        p.drawImage(dst, face, face.rect());
+        p.end();
+
+        FramePipeline pipeline;
+        if (!startPipeline(pipeline, outGifPath, outSizePx, frame.size(), fps, errOut)) return false;
+        pipeline.push(std::move(frame));
+        return finish(pipeline, errOut);
+    }
+
+    // Animated flip with backside: vertical thickness + swap face when cos < 0
+    const int totalFrames = frameCount(fps, durationSec);
+    if (totalFrames < 1) { if (errOut) *errOut = "Total frames computed < 1."; return false; }
+
+    // Several cycles: one of them loops just the same
+    const int period = loopPeriod({ qreal(qMax(1, cycles)) / totalFrames }, totalFrames);
+
+    const qreal eps = 0.08; // thickness floor so it never vanishes
+    FramePipeline pipeline;
+    if (!startPipeline(pipeline, outGifPath, outSizePx, frontBase.size(), fps, errOut)) return false;
+
+    const AffineWarp frontWarp(frontBase);
+    const AffineWarp backWarp(backForFlip);
+
+    // Only the face and |cos| matter: phi and 360-phi give the same frame
+    const auto poseOf = [&](int i) -> QString {
+        const qreal c = qCos(2.0 * M_PI * qMax(1, cycles) * (i % period) / totalFrames);
+        return poseKey(c < 0.0 ? backForFlip : frontBase, std::abs(c));
+    };
+
+    pipeline.renderFrames(framesToWrite(period, totalFrames), poseOf, [&](int i) -> QImage {
+        const qreal t   = (qreal)(i % period) / (qreal)totalFrames;
+        const qreal phi = 2.0 * M_PI * qMax(1, cycles) * t;
+
+        const qreal c   = qCos(phi);
+        const bool showBack = (c < 0.0);
+        const qreal syAbs  = (1.0 - eps) * std::abs(c) + eps; // vertical “thickness”
+        const AffineWarp &face = showBack ? backWarp : frontWarp;
+
+        QTransform tr;
+        tr.translate(center.x(), center.y());
+        tr.scale(1.0, syAbs); // NO SHEAR → no tilt
+        tr.translate(-center.x(), -center.y());
+
+        QImage frame = pipeline.framePool().acquire(bg, face.bounds(tr));
+        face.draw(frame, tr);
+        return frame;
+    });
+
+    return finish(pipeline, errOut);
+}
+
+bool GifEngine::generateCompositeGif(const QString &frontImagePath,
+                                      const QString &outGifPath,
+                                      int fps,
+                                      qreal durationSec,
+                                      int sizePx,
+                                      bool useZSpin,
+                                      qreal zDegPerSec,
+                                      bool useYaw,
+                                      qreal maxYawRotations,   // your UI uses rotations count here
+                                      bool useFlip,
+                                      bool flipAnimate,
+                                      int flipCycles,
+                                      const QColor &bg,
+                                      QString *errOut)
+{
+    const bool cropContent = m_options.cropToContent;
+
+    if (!QFileInfo::exists(frontImagePath)) { if (errOut) *errOut="Front image does not exist."; return false; }
+    if (fps <= 0 || durationSec <= 0)       { if (errOut) *errOut="FPS and duration must be > 0."; return false; }
+    if (sizePx < 32) sizePx = 256;
+    const int outSizePx = sizePx;
+    sizePx = renderSizePx(outSizePx);
+
+    // Load, optional crop-to-content, canvases
+    const QImage frontBase = prepareCanvas(frontImagePath, cropContent, sizePx, bg);
+    if (frontBase.isNull()) { if (errOut) *errOut="Failed to load front image."; return false; }
+
+    // Resolve/auto-simulate backside
+    const QImage backCanvas = prepareBackCanvas(frontImagePath, cropContent, sizePx, bg);
+    const bool haveBack = !backCanvas.isNull();
+    const QImage backBase = haveBack ? backCanvas : frontBase;
+
+    // Upside-down only for FLIP backs
+    RunProfile::Scope canvas(m_profile, RunProfile::Canvas);
+    const bool upsideDown = (m_options.backsideMode == BacksideUpsideDown);
+    const QImage backForFlip = upsideDown ? backBase.mirrored(true, true) : backBase;
+
+    const QSize  canvasSize = frontBase.size();
+    const QPointF center(canvasSize.width()/2.0, canvasSize.height()/2.0);
+
+    const AffineWarp frontWarp(frontBase);
+    const AffineWarp backWarp(backBase);
+    const AffineWarp flipWarp(backForFlip);
+    canvas.stop(upsideDown ? backForFlip.sizeInBytes() : 0);
+
+    // Frames
+    const int totalFrames = frameCount(fps, durationSec);
+    if (totalFrames < 1) { if (errOut) *errOut = "Total frames computed < 1."; return false; }
+
+    // One true period of all active motions: Z spin turns zDegPerSec/360 per
+    // second, yaw and flip run their cycles over the whole duration (which the
+    // UI rounds up to whole seconds, so the run often repeats itself)
+    QVector<qreal> turnsPerFrame;
+    if (useZSpin)                turnsPerFrame << zDegPerSec / (360.0 * fps);
+    if (useYaw)                  turnsPerFrame << qMax<qreal>(0.0, maxYawRotations) / totalFrames;
+    if (useFlip && flipAnimate)  turnsPerFrame << qreal(qMax(1, flipCycles)) / totalFrames;
+    const int period = loopPeriod(turnsPerFrame, totalFrames);
+    const int frames = framesToWrite(period, totalFrames);
+    if (frames < totalFrames)
+        log(QStringLiteral("Composite loops every %1 frames; writing %1 of %2").arg(period).arg(totalFrames));
+
+    const qreal eps = 0.08; // thickness floors
+    FramePipeline pipeline;
+    if (!startPipeline(pipeline, outGifPath, outSizePx, canvasSize, fps, errOut)) return false;
+
+    // Face and transform of frame i; later periods reuse the first one's
+    // poses exactly, so their frames are rendered only once
+    struct Pose { const QImage *face; qreal zDeg, sxAbs, syAbs; };
+    const auto poseAt = [&](int i) -> Pose {
+        const qreal t01 = (qreal)(i % period) / (qreal)totalFrames;
+
+        // Z spin angle
+        const qreal zDeg = useZSpin ? (zDegPerSec * (i % period) / fps) : 0.0;
+
+        // Yaw → which side due to spin?
+        bool  yawBack = false;
+        qreal sxAbs   = 1.0;
+        if (useYaw) {
+            const qreal cx = qCos(2.0 * M_PI * qMax<qreal>(0.0, maxYawRotations) * t01);
+            yawBack = (cx < 0.0);
+            sxAbs   = (1.0 - eps) * std::abs(cx) + eps;   // horizontal “thickness”
+        }
+
+        // Flip → which side due to flip?
+        bool  flipBack = false;
+        qreal syAbs    = 1.0;
+        if (useFlip) {
+            if (!flipAnimate) {
+                flipBack = true; // static “show back”
+            } else {
+                const qreal phi = 2.0 * M_PI * qMax(1, flipCycles) * t01;
+                const qreal cy  = qCos(phi);
+                flipBack = (cy < 0.0);
+                syAbs    = (1.0 - eps) * std::abs(cy) + eps; // vertical “thickness”
+            }
+        }
+
+        // Back shown iff exactly one axis says “back”
+        const bool showBack = (yawBack ^ flipBack);
+
+        // Choose which back to use based on WHY we’re showing it:
+        // - if back is from FLIP -> use upside-down option
+        // - if back is from YAW -> use normal back
+        const QImage &face = showBack
+                           ? ((flipBack && !yawBack) ? backForFlip : backBase)
+                           : frontBase;
+
+        return Pose{ &face, zDeg, sxAbs, syAbs };
+    };
+
+    // Yaw and flip only depend on |cos|, and the spin repeats every 360 degrees
+    const auto poseOf = [&](int i) -> QString {
+        const Pose pose = poseAt(i);
+        return poseKey(*pose.face, wrapDegrees(pose.zDeg), pose.sxAbs, pose.syAbs);
+    };
+
+    pipeline.renderFrames(frames, poseOf, [&](int i) -> QImage {
+        const Pose pose = poseAt(i);
+        const AffineWarp &face = (pose.face == &frontBase) ? frontWarp
+                               : (pose.face == &backBase)  ? backWarp
+                                                           : flipWarp;
+
+        QTransform tr;
+        tr.translate(center.x(), center.y());
+        if (useZSpin) tr.rotate(pose.zDeg);
+        tr.scale(pose.sxAbs, pose.syAbs);
+        tr.translate(-center.x(), -center.y());
+
+        // Recycled frame: only the previous face's bounds are cleared
+        QImage frame = pipeline.framePool().acquire(bg, face.bounds(tr));
+        face.draw(frame, tr, /*smoothEdges=*/true);
+        return frame;
+    });
+
+    return finish(pipeline, errOut);
+}
+
+// Main globe generation function with backside and rotation axis support
+bool GifEngine::generateGlobeGif(const QString &frontImagePath,
+                                 const QString &backImagePath,
+                                 const QString &outGifPath,
+                                 int fps,
+                                 qreal durationSec,
+                                 int sizePx,
+                                 qreal rotationSpeed,
+                                 qreal zoomPercent,
+                                 int rotationAxis,
+                                 const QColor &globeSurfaceColor,
+                                 QString *errOut)
+{
+    // Validate inputs
+    if (frontImagePath.isEmpty()) {
+        if (errOut) *errOut = "No front image path provided.";
+        return false;
+    }
+    if (!QFileInfo::exists(frontImagePath)) {
+        if (errOut) *errOut = "Front image does not exist.";
+        return false;
+    }
+    if (fps <= 0 || durationSec <= 0) {
+        if (errOut) *errOut = "FPS and duration must be > 0.";
+        return false;
+    }
+    if (sizePx < 64) sizePx = 512;
+    const int outSizePx = sizePx;
+    sizePx = renderSizePx(outSizePx);
+
+    // Textures are decoded at up to twice the globe size (a face is
+    // magnified about pi/2 at its centre), more when zooming in crops them
+    const int texturePx = qCeil(2.0 * sizePx * qMax(qreal(1.0), zoomPercent / 100.0));
+    const QSize textureFit(texturePx, texturePx);
+
+    // Load front texture (ARGB32, zoom applied)
+    const QImage frontTexture = prepareTexture(frontImagePath, textureFit, zoomPercent, globeSurfaceColor);
+    if (frontTexture.isNull()) {
+        if (errOut) *errOut = "Failed to load front texture image.";
+        return false;
+    }
+
+    // Load back texture (optional): the given file, or else the run's back
+    // face (explicit or simulated, see resolveBackImage)
+    QImage backTexture;
+    if (!backImagePath.isEmpty()) {
+        if (QFileInfo::exists(backImagePath))
+            backTexture = prepareTexture(backImagePath, textureFit, zoomPercent, globeSurfaceColor);
+    } else {
+        QString backKey;
+        const QImage back = resolveBackImage(frontImagePath, &backKey, textureFit);
+        if (!back.isNull())
+            backTexture = prepareTexture(backKey, [&] { return back; }, textureFit,
+                                         zoomPercent, globeSurfaceColor);
+    }
+
+    // Calculate frames
+    const int totalFrames = frameCount(fps, durationSec);
+    if (totalFrames < 1) {
+        if (errOut) *errOut = "Total frames computed < 1.";
+        return false;
+    }
+
+    const qreal degreesPerFrame = (rotationSpeed * 360.0) / totalFrames;
+
+    // Always use transparent background for the frame canvas
+    const QColor frameBackground = Qt::transparent;
+
+    // Frames are encoded as they are rendered
+    FramePipeline pipeline;
+    if (!startPipeline(pipeline, outGifPath, outSizePx, QSize(sizePx, sizePx), fps, errOut)) return false;
+
+    // Horizontal spins only shift longitude: precompute the texel mapping once
+    QScopedPointer<GlobeScrollRenderer> scroll;
+    QScopedPointer<TextureSampler> sampler;
+    RunProfile::Scope setup(m_profile, RunProfile::Canvas);
+    if (rotationAxis == 0)
+        scroll.reset(new GlobeScrollRenderer(frontTexture, backTexture, sizePx,
+                                             globeSurfaceColor, true));
+    else
+        sampler.reset(new TextureSampler(frontTexture, backTexture, globeSurfaceColor));
+    setup.stop();
+
+    // More than one turn revisits the same rotations (the tilted axis uses
+    // half-angles, so it only repeats every 720 degrees)
+    const qreal posePeriod = (rotationAxis == 2) ? 720.0 : 360.0;
+    const auto poseOf = [&](int i) -> QString {
+        return poseKey(frontTexture, wrapDegrees(i * degreesPerFrame, posePeriod));
+    };
+
+    // Generate each frame (rendered in parallel, encoded in order)
+    pipeline.renderFrames(totalFrames, poseOf, [&](int i) -> QImage {
+        const qreal rotation = i * degreesPerFrame;
+        // Every frame rewrites the same disc, so a recycled frame needs no clearing
+        QImage frame = pipeline.framePool().acquire(frameBackground, QRect(0, 0, sizePx, sizePx), true);
+        if (scroll) scroll->render(frame, rotation);
+        else        drawGlobeFrame(frame, *sampler, rotation, true, rotationAxis);
+        return frame;
+    });
+
+    // Encode GIF
+    return finish(pipeline, errOut);
+}
+
+
+// Frames in a run of 'durationSec' at 'fps': rounded to a whole frame, at least 1
+int GifEngine::frameCount(int fps, qreal durationSec)
+{
+    return qMax(1, qRound(fps * durationSec));
+}
+
+// Helper: Zoom image
+// New behavior:
+//   <100%  = shrink image and pad to original size (appears smaller on globe)
+//   100%   = unchanged
+//   >100%  = crop central region (appears larger on globe)
+QImage GifEngine::zoomImage(const QImage &src, qreal zoomPercent, const QColor &padColor)
+{
+    if (src.isNull()) return src;
+
+    // Treat ~100% as "no change"
+    if (qAbs(zoomPercent - 100.0) < 0.1) return src;
+
+    // Safety clamps
+    if (zoomPercent <= 0.0) zoomPercent = 1.0;
+
+    if (zoomPercent > 100.0) {
+        // ZOOM IN (make features larger on the globe):
+        // keep only the central portion of the texture (crop)
+        // e.g. 200% -> keep 50% width/height centered
+        const qreal keep = 100.0 / zoomPercent;         // fraction of original to keep
+        const int newW   = qMax(1, qRound(src.width()  * keep));
+        const int newH   = qMax(1, qRound(src.height() * keep));
+        const int x      = (src.width()  - newW) / 2;
+        const int y      = (src.height() - newH) / 2;
+
+        // Return the cropped texture; the sampler maps the smaller image across the sphere,
+        // which effectively enlarges features.
+        return src.copy(x, y, newW, newH);
+    } else {
+        // ZOOM OUT (make features smaller on the globe):
+        // scale the image down, then center it on a canvas the original size
+        const qreal scale = zoomPercent / 100.0;        // e.g. 50% -> 0.5 scale
+        const int newW    = qMax(1, qRound(src.width()  * scale));
+        const int newH    = qMax(1, qRound(src.height() * scale));
+
+        QImage result(src.width(), src.height(), QImage::Format_ARGB32);
+        result.fill(padColor);
+
+        QImage scaled = src.scaled(newW, newH, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        const int x   = (src.width()  - scaled.width())  / 2;
+        const int y   = (src.height() - scaled.height()) / 2;
+
+        QPainter p(&result);
+        p.drawImage(x, y, scaled);
+        p.end();
+
+        return result;
+    }
+}
+
@@ -0,0 +1,242 @@
+#ifndef GIFENGINE_H
+#define GIFENGINE_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QImage>
+#include <QColor>
+#include <QList>
+#include <functional>
+#include <atomic>
+#include "framepipeline.h"
+
+class TextureSampler;
+class QThreadPool;
+class RunProfile;
+
+// The GIF generators, independent of any widget.
+//
+// Everything the generators used to read from the window (back image path,
+// crop-to-content, backside simulation) comes in through Options, so the same
+// code runs behind MainWindow and behind the headless gifstew-cli.
+//
+//   GifEngine::Options opts;
+//   opts.backImagePath = back;
+//   GifEngine engine(opts);
+//   if (!engine.generateCompositeGif(src, out, ..., &err)) ...
+class GifEngine
+{
+    Q_DECLARE_TR_FUNCTIONS(GifEngine)
+
+public:
+    // Same values as the "backfaceMode" setting
+    enum BacksideMode { BacksideOff = 0, BacksideNormal = 1, BacksideUpsideDown = 2 };
+    // The saved "backfaceMode" setting (off when unset or out of range)
+    static BacksideMode defaultBacksideMode();
+
+    struct Options {
+        QString      backImagePath;              // explicit back face (optional)
+        bool         cropToContent = false;      // trim borders before square-padding
+        BacksideMode backsideMode  = defaultBacksideMode(); // simulate the back from the front
+
+        // FramePipeline knobs; default to the saved settings
+        int                        renderThreads  = FramePipeline::defaultWorkerCount();
+        FramePipeline::PaletteMode paletteMode    = FramePipeline::defaultPaletteMode();
+        bool                       optimizeFrames = FramePipeline::defaultOptimizeFrames();
+
+        // Shared render pool (not owned), e.g. for a batch of jobs running at
+        // once; null = each run renders on its own renderThreads workers
+        QThreadPool               *renderPool     = nullptr;
+
+        // More sizes (px, square side) to write from the same run, each to
+        // sizedOutputPath(outGifPath, size). Frames are rendered once at the
+        // largest size and box-downscaled for the others (see
+        // FramePipeline::addOutput()). Empty = just sizePx.
+        QList<int>                 outputSizes;
+    };
+
+    GifEngine();
+    explicit GifEngine(const Options &options);
+
+    const Options &options() const { return m_options; }
+    void setOptions(const Options &options) { m_options = options; }
+
+    // Receives non-fatal diagnostics (e.g. a failed backside simulation).
+    // Defaults to qDebug().
+    void setLogger(const std::function<void(const QString &)> &logger) { m_logger = logger; }
+
+    // Frames written by the last generator call (0 if it failed early)
+    int lastFrameCount() const { return m_lastFrameCount; }
+
+    // Per-frame progress, called on the encoder thread (see FramePipeline::setProgress)
+    void setProgress(const std::function<void(int done, int total)> &progress) { m_progress = progress; }
+
+    // Set '*flag' from any thread to stop a running generator: it fails with
+    // "Cancelled." within a frame and leaves no output behind
+    void setCancelFlag(const std::atomic<bool> *flag) { m_cancel = flag; }
+
+    // Preview: hand the frames to 'sink' instead of writing outGifPath
+    // (see FramePipeline::setFrameSink)
+    void setFrameSink(const std::function<void(const QImage &frame)> &sink) { m_sink = sink; }
+
+    // Per-stage timing and frame memory of the generator calls go to
+    // 'profile' (not owned; see RunProfile). Null (default) = not measured.
+    void setProfile(RunProfile *profile) { m_profile = profile; }
+
+    // --- Generators: write an animated GIF to outGifPath; false + *errOut on failure
+    // Timing: frame i is shown at i / fps seconds, and the run has frameCount()
+    // frames, so fractional durations are kept to the nearest frame
+    bool generateSpinGif(const QString &srcImagePath,
+                         const QString &outGifPath,
+                         int fps, qreal durationSec, int sizePx,
+                         const QColor &bg, QString *errOut);
+
+    bool generateOscillateGif(const QString &srcImagePath,
+                              const QString &outGifPath,
+                              int fps, qreal durationSec, int sizePx,
+                              qreal maxDegrees,
+                              const QColor &bg, QString *errOut);
+
+    bool generateYawSpinGif(const QString &srcImagePath,
+                            const QString &outGifPath,
+                            int fps, qreal durationSec, int sizePx,
+                            qreal maxYawDeg,
+                            const QColor &bg, QString *errOut);
+
+    bool generateFlipGif(const QString &srcImagePath,
+                         const QString &outGifPath,
+                         int fps, qreal durationSec, int sizePx,
+                         bool animate, int cycles,
+                         const QColor &bg, QString *errOut);
+
+    bool generateCompositeGif(const QString &srcImagePath,
+                              const QString &outGifPath,
+                              int fps, qreal durationSec, int sizePx,
+                              bool useZSpin, qreal zDegPerSec,
+                              bool useYaw, qreal maxYawDeg,
+                              bool useFlip, bool flipAnimate, int flipCycles,
+                              const QColor &bg, QString *errOut);
+
+    // backImagePath: back texture file; empty = resolveBackImage(frontImagePath)
+    bool generateGlobeGif(const QString &frontImagePath,
+                          const QString &backImagePath,
+                          const QString &outGifPath,
+                          int fps, qreal durationSec, int sizePx,
+                          qreal rotationSpeed, qreal zoomPercent,
+                          int rotationAxis,
+                          const QColor &globeSurfaceColor,
+                          QString *errOut);
+
+    // Legacy PNG-sequence variants (frames written to outDir)
+    bool generateSpinGif(const QString &frontPath,
+                         const QString &backPath,
+                         const QString &outDir,
+                         int fps, int durationSec,
+                         qreal maxAngleDeg, int cycles,
+                         QString *errOut);
+
+    bool generateFlipGif(const QString &frontPath,
+                         const QString &backPath,
+                         const QString &outDir,
+                         int fps, int durationSec,
+                         qreal maxAngleDeg, int cycles,
+                         QString *errOut);
+
+    // --- Globe rendering
+    QImage renderGlobeFrame(const QImage &frontTexture,
+                            const QImage &backTexture,
+                            qreal rotationDegrees, int sizePx,
+                            const QColor &frameBg,
+                            const QColor &globeSurfaceColor,
+                            bool enableLighting,
+                            int rotationAxis);
+
+    QImage renderGlobeFrame(const TextureSampler &sampler,
+                            qreal rotationDegrees, int sizePx,
+                            const QColor &frameBg,
+                            bool enableLighting,
+                            int rotationAxis);
+
+    // Into a square 'frame' that already holds the background: only the disc
+    // is written (every pixel of it, no blending)
+    void drawGlobeFrame(QImage &frame, const TextureSampler &sampler,
+                        qreal rotationDegrees, bool enableLighting, int rotationAxis);
+
+    // Frames in a run of 'durationSec' at 'fps': rounded to a whole frame, at least 1
+    static int frameCount(int fps, qreal durationSec);
+
+    // --- Multi-resolution output (Options::outputSizes)
+    // "out.gif", 256 -> "out_256.gif"
+    static QString sizedOutputPath(const QString &outGifPath, int sizePx);
+    // "128,256 512" -> {128, 256, 512}; *ok = false if any entry is not a
+    // size in [16, 4096] (the valid ones are still returned)
+    static QList<int> parseSizeList(const QString &text, bool *ok = nullptr);
+
+    static QImage zoomImage(const QImage &src, qreal zoomPercent, const QColor &padColor);
+
+    // --- Source preparation
+    // Trims transparent (or flat, for opaque images) borders
+    static QImage cropToContentSmart(const QImage &src, int alphaThreshold = 8);
+    // The part cropToContentSmart() keeps (the whole image if nothing to trim)
+    static QRect contentRect(const QImage &src, int alphaThreshold = 8);
+    // Scales 'src' to fit a sizePx square, centred on 'bg'
+    static QImage makeSquareCanvas(const QImage &src, int sizePx, const QColor &bg);
+
+    // --- Back face
+    // Back image for a run on 'frontPath': the explicit back, or one simulated
+    // from the front (makeBacksideFrom) when backsideMode is on. It stays in
+    // memory; the simulated one is cached next to the front's decode. Null
+    // means single-sided; failures are logged. '*keyOut' gets its SourceCache
+    // key. A valid fitSize decodes no larger than that (see loadImage).
+    QImage resolveBackImage(const QString &frontPath, QString *keyOut = nullptr,
+                            const QSize &fitSize = QSize(), bool crop = false) const;
+
+    QImage ensureBackImageForRun(const QString &frontPath,
+                                 const QString &explicitBackPath,
+                                 bool simulateBack,
+                                 QString *keyOut,
+                                 QString *errOut,
+                                 const QSize &fitSize = QSize(),
+                                 bool crop = false) const;
+
+    bool resolveFrontBackImages(const QString &frontPath,
+                                const QString &maybeBackPath,
+                                QImage &frontOut,
+                                QImage &backOut,
+                                QString *errOut);
+
+    const QImage &pickFaceForAngle(const QImage &front,
+                                   const QImage &back,
+                                   qreal angleDeg) const;
+
+    static QImage makeBacksideFrom(const QImage &front, bool *ok, QString *errOut);
+
+private:
+    void configure(FramePipeline &pipeline);
+    QList<int> runSizes(int sizePx) const;
+    int renderSizePx(int sizePx) const;
+    bool startPipeline(FramePipeline &pipeline, const QString &outGifPath, int outSizePx,
+                       const QSize &canvasSize, int fps, QString *errOut);
+    bool finish(FramePipeline &pipeline, QString *errOut);
+    void log(const QString &msg) const;
+    QImage loadImage(const QString &path, const QSize &fitSize = QSize(), bool crop = false,
+                     QString *keyOut = nullptr) const;
+    QImage prepareCanvas(const QString &path, bool crop, int sizePx, const QColor &bg) const;
+    QImage prepareCanvas(const QString &sourceKey, const std::function<QImage()> &load,
+                         bool crop, int sizePx, const QColor &bg) const;
+    QImage prepareTexture(const QString &path, const QSize &fitSize,
+                          qreal zoomPercent, const QColor &padColor) const;
+    QImage prepareTexture(const QString &sourceKey, const std::function<QImage()> &load,
+                          const QSize &fitSize, qreal zoomPercent, const QColor &padColor) const;
+    QImage prepareBackCanvas(const QString &frontPath, bool crop, int sizePx, const QColor &bg) const;
+
+    Options m_options;
+    std::function<void(const QString &)> m_logger;
+    int m_lastFrameCount = 0;
+    std::function<void(int, int)> m_progress;
+    const std::atomic<bool> *m_cancel = nullptr;
+    std::function<void(const QImage &)> m_sink;
+    RunProfile *m_profile = nullptr;
+};
+
+#endif // GIFENGINE_H
@@ -0,0 +1,98 @@
+#include "globescroll.h"
+#include "sphereprojection.h"
+#include <QtMath>
+
+namespace {
+
+constexpr int kCosBits = 12;   // |cos| table resolution
+
+} // namespace
+
+GlobeScrollRenderer::GlobeScrollRenderer(const QImage &frontTexture,
+                                         const QImage &backTexture,
+                                         int sizePx,
+                                         const QColor &globeSurfaceColor,
+                                         bool enableLighting)
+    : m_sizePx(sizePx)
+    , m_sampler(frontTexture, backTexture, globeSurfaceColor)
+    , m_lighting(enableLighting)
+{
+    const QSharedPointer<const SphereProjection> proj = SphereProjection::forSize(sizePx);
+
+    m_rowX0.resize(sizePx);
+    m_rowCount.resize(sizePx);
+    m_rowOffset.resize(sizePx);
+    for (int y = 0; y < sizePx; ++y) {
+        m_rowX0[y]     = proj->rows[y].x0;
+        m_rowCount[y]  = proj->rows[y].count;
+        m_rowOffset[y] = proj->rows[y].offset;
+    }
+
+    const int n = proj->nx.size();
+    m_lon.resize(n);
+    m_yFront.resize(n);
+    m_yBack.resize(n);
+    m_radiusXZ.resize(n);
+
+    for (int i = 0; i < n; ++i) {
+        const qreal nx = proj->nx[i];
+        const qreal ny = proj->ny[i];
+        const qreal nz = proj->nz[i];
+
+        const qreal lat = qAsin(qBound<qreal>(-1.0, ny, 1.0));
+        m_lon[i]      = TextureSampler::turnsFor(qAtan2(nx, nz));
+        m_yFront[i]   = TextureSampler::rowFor(lat, m_sampler.frontHeight());
+        m_yBack[i]    = TextureSampler::rowFor(lat, m_sampler.backHeight());
+        m_radiusXZ[i] = quint16(qRound(qMin<qreal>(1.0, qSqrt(nx*nx + nz*nz)) * 65535.0));
+    }
+
+    m_absCos.resize(1 << kCosBits);
+    for (int i = 0; i < m_absCos.size(); ++i) {
+        const qreal lon = (i + 0.5) * (2.0 * M_PI) / m_absCos.size();
+        m_absCos[i] = quint16(qRound(qAbs(qCos(lon)) * 65535.0));
+    }
+}
+
+QImage GlobeScrollRenderer::render(qreal rotationDegrees, const QColor &frameBg) const
+{
+    QImage frame(m_sizePx, m_sizePx, QImage::Format_ARGB32_Premultiplied);
+    frame.fill(frameBg);
+    render(frame, rotationDegrees);
+    return frame;
+}
+
+void GlobeScrollRenderer::render(QImage &frame, qreal rotationDegrees) const
+{
+    if (m_sampler.isNull()) return;
+
+    // Turning the sphere by +R moves every pixel's longitude by -R
+    const quint32 shift = TextureSampler::turnsFor(qDegreesToRadians(rotationDegrees));
+
+    QVector<quint32> lon(m_sizePx);
+    for (int py = 0; py < m_sizePx; ++py) {
+        const int count  = m_rowCount[py];
+        const int offset = m_rowOffset[py];
+        QRgb *dst = reinterpret_cast<QRgb *>(frame.scanLine(py)) + m_rowX0[py];
+
+        for (int k = 0; k < count; ++k)
+            lon[k] = m_lon[offset + k] - shift;
+
+        // Front/back split and the back texture's half-turn offset are
+        // handled inside the sampler
+        m_sampler.sampleRow(lon.constData(), m_yFront.constData() + offset,
+                            m_yBack.constData() + offset, dst, count);
+
+        if (!m_lighting) continue;
+        for (int k = 0; k < count; ++k) {
+            const int idx = offset + k;
+            const QRgb c = dst[k];
+            // brightness = clamp(|rotated nz|, 0.75, 1) with nz = r_xz * cos(lon)
+            quint32 b = (quint32(m_radiusXZ[idx]) * m_absCos[lon[k] >> (32 - kCosBits)]) >> 16;
+            b = qBound<quint32>(49152u, b, 65535u);
+            const quint32 r  = ((qRed(c)   * b) + 32768u) >> 16;
+            const quint32 g  = ((qGreen(c) * b) + 32768u) >> 16;
+            const quint32 bl = ((qBlue(c)  * b) + 32768u) >> 16;
+            dst[k] = (c & 0xFF000000u) | (r << 16) | (g << 8) | bl;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef GLOBESCROLL_H
+#define GLOBESCROLL_H
+
+#include "texturesampler.h"
+#include <QImage>
+#include <QColor>
+#include <QVector>
+
+// Fast path for a globe spinning about its vertical axis (rotationAxis == 0).
+//
+// Turning the sphere about Y leaves every pixel's latitude alone and shifts its
+// longitude by the rotation angle. So the per-pixel (lon, lat) -> texel mapping
+// is computed once, and each frame is a single offset-and-sample pass with no
+// trigonometry.
+//
+// Longitudes are stored as 32-bit fixed-point turns (2^32 == 360°), so the
+// per-frame shift and the wrap-around at ±180° are plain unsigned arithmetic.
+//
+// Produces the same image as MainWindow::renderGlobeFrame(..., rotationAxis = 0)
+// up to fixed-point rounding. render() is const and safe to call from several
+// threads.
+class GlobeScrollRenderer
+{
+public:
+    GlobeScrollRenderer(const QImage &frontTexture,
+                        const QImage &backTexture,
+                        int sizePx,
+                        const QColor &globeSurfaceColor,
+                        bool enableLighting);
+
+    QImage render(qreal rotationDegrees, const QColor &frameBg) const;
+
+    // Same, into a sizePx() square 'frame' that already holds the background:
+    // only the disc is written (every pixel of it, no blending)
+    void render(QImage &frame, qreal rotationDegrees) const;
+
+    int sizePx() const { return m_sizePx; }
+
+private:
+    int            m_sizePx = 0;
+    TextureSampler m_sampler;
+    bool           m_lighting = true;
+
+    // Per disc pixel (row-major, same layout as SphereProjection)
+    QVector<int>     m_rowX0, m_rowCount, m_rowOffset;
+    QVector<quint32> m_lon;         // longitude at rotation 0, in turns (2^32 == 360°)
+    QVector<quint32> m_yFront;      // texel row in the front texture, 16.16 fixed point
+    QVector<quint32> m_yBack;       // texel row in the back texture, 16.16 fixed point
+    QVector<quint16> m_radiusXZ;    // sqrt(nx² + nz²), 0..65535 (lighting)
+
+    // |cos| by longitude (top 12 bits of the turn), 0..65535
+    QVector<quint16> m_absCos;
+};
+
+#endif // GLOBESCROLL_H
@@ -1,11 +1,10 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "gifengine.h"
 #include <QMessageBox>
 #include <QProcess>
 #include <QTemporaryDir>
 #include <QImage>
-#include <QPainter>
-#include <QTransform>
 #include <QtMath>
 #include <QFileInfo>
 #include <QDir>
@@ -27,119 +26,17 @@
 #include <QMovie>
 #include <QButtonGroup>
 #include <QObject>
+#include <QThread>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QStatusBar>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QLineEdit>
+#include <QJsonObject>
+#include <QDebug>
 
-namespace {
-
-// (inside your existing anonymous namespace)
-static QImage cropToContentSmart(const QImage &src, int alphaThreshold = 8)
-{
-    if (src.isNull()) return src;
-
-    QImage img = src.convertToFormat(QImage::Format_ARGB32);
-    const int w = img.width();
-    const int h = img.height();
-
-    bool hasAlpha = img.hasAlphaChannel();
-    if (hasAlpha) {
-        int minX = w, minY = h, maxX = -1, maxY = -1;
-        const uchar *bits = img.bits();
-        const int stride = img.bytesPerLine();
-        for (int y = 0; y < h; ++y) {
-            const uchar* row = bits + y * stride;
-            for (int x = 0; x < w; ++x) {
-                const uchar a = row[x * 4 + 3];
-                if (a > alphaThreshold) {
-                    if (x < minX) minX = x;
-                    if (x > maxX) maxX = x;
-                    if (y < minY) minY = y;
-                    if (y > maxY) maxY = y;
-                }
-            }
-        }
-        if (maxX >= minX && maxY >= minY) {
-            return img.copy(QRect(QPoint(minX, minY), QPoint(maxX, maxY)));
-        }
-        return img;
-    }
-
-    const QColor border = QColor::fromRgba(img.pixel(0, 0));
-    auto close = [](const QColor &a, const QColor &b, int tol=2){
-        return std::abs(a.red()   - b.red())   <= tol &&
-               std::abs(a.green() - b.green()) <= tol &&
-               std::abs(a.blue()  - b.blue())  <= tol;
-    };
-
-    int left = 0, right = w - 1, top = 0, bottom = h - 1;
-
-    for (; left < w; ++left) {
-        bool allBorder = true;
-        for (int y = 0; y < h; ++y)
-            if (!close(QColor::fromRgba(img.pixel(left, y)), border)) { allBorder = false; break; }
-        if (!allBorder) break;
-    }
-    for (; right >= left; --right) {
-        bool allBorder = true;
-        for (int y = 0; y < h; ++y)
-            if (!close(QColor::fromRgba(img.pixel(right, y)), border)) { allBorder = false; break; }
-        if (!allBorder) break;
-    }
-    for (; top < h; ++top) {
-        bool allBorder = true;
-        for (int x = left; x <= right; ++x)
-            if (!close(QColor::fromRgba(img.pixel(x, top)), border)) { allBorder = false; break; }
-        if (!allBorder) break;
-    }
-    for (; bottom >= top; --bottom) {
-        bool allBorder = true;
-        for (int x = left; x <= right; ++x)
-            if (!close(QColor::fromRgba(img.pixel(x, bottom)), border)) { allBorder = false; break; }
-        if (!allBorder) break;
-    }
-
-    if (right >= left && bottom >= top)
-        return img.copy(QRect(QPoint(left, top), QPoint(right, bottom)));
-    return img;
-}
-
-// --- NEW: find the bounding box of non-transparent pixels ---
-// Returns an empty QRect if the image is fully transparent or invalid.
-// alphaThreshold: treat pixels with alpha <= threshold as transparent (default 8).
-static QRect cropToOpaqueBounds(const QImage &img, int alphaThreshold = 8)
-{
-    if (img.isNull())
-        return QRect();
-
-    // If there’s no alpha channel, treat the whole image as opaque.
-    if (!img.hasAlphaChannel())
-        return QRect(0, 0, img.width(), img.height());
-
-    int minX = img.width();
-    int minY = img.height();
-    int maxX = -1;
-    int maxY = -1;
-
-    for (int y = 0; y < img.height(); ++y) {
-        const QRgb *row = reinterpret_cast<const QRgb *>(img.constScanLine(y));
-        for (int x = 0; x < img.width(); ++x) {
-            if (qAlpha(row[x]) > alphaThreshold) {
-                if (x < minX) minX = x;
-                if (y < minY) minY = y;
-                if (x > maxX) maxX = x;
-                if (y > maxY) maxY = y;
-            }
-        }
-    }
-
-    if (maxX < minX || maxY < minY) {
-        // No opaque pixels found
-        return QRect();
-    }
-
-    // QRect takes x, y, width, height (inclusive bounds -> +1)
-    return QRect(minX, minY, (maxX - minX + 1), (maxY - minY + 1));
-}
-
-} // namespace
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -177,500 +74,50 @@ MainWindow::MainWindow(QWidget *parent)
     if (ui->radioFlipUD)    { grp->addButton(ui->radioFlipUD);    ui->radioFlipUD->setAutoExclusive(false); }
     if (ui->radioGlobe)     { grp->addButton(ui->radioGlobe);     ui->radioGlobe->setAutoExclusive(false); }
 
-    connectUiActions();
-}
-
-MainWindow::~MainWindow()
-{
-    delete ui;
-}
-
-// --- Helper: find ImageMagick binary ("magick" preferred; fall back to "convert")
-static QString findImageMagick()
-{
-    // Try v7 "magick" first
-    QStringList candidates = { "magick", "convert" };
-    for (const QString &bin : candidates) {
-        QString which = QStandardPaths::findExecutable(bin);
-        if (!which.isEmpty()) return which;
-    }
-    return QString();
-}
-
-// --- Helper: draw 'src' centered on a square canvas to prevent clipping when rotated
-static QImage makeSquareCanvas(const QImage &src, int sizePx, const QColor &bg)
-{
-    QImage canvas(sizePx, sizePx, QImage::Format_ARGB32_Premultiplied);
-    canvas.fill(bg);
-    QPainter p(&canvas);
-    p.setRenderHint(QPainter::SmoothPixmapTransform, true);
-    const QSize scaled = src.size().scaled(QSize(sizePx, sizePx), Qt::KeepAspectRatio);
-    const QPoint topLeft( (sizePx - scaled.width())/2, (sizePx - scaled.height())/2 );
-    p.drawImage(QRect(topLeft, scaled), src);
-    p.end();
-    return canvas;
-}
-
-// --- Helper: write frames as PNGs to framesDir (frame_0000.png, frame_0001.png, …)
-static bool writeFrames(const QList<QImage> &frames, const QString &framesDir, QString *errOut)
-{
-    QDir().mkpath(framesDir);
-    for (int i = 0; i < frames.size(); ++i) {
-        const QString fn = QString("%1/frame_%2.png")
-                               .arg(framesDir)
-                               .arg(i, 4, 10, QChar('0'));
-        if (!frames[i].save(fn, "PNG")) {
-            if (errOut) *errOut = QString("Failed saving %1").arg(fn);
-            return false;
-        }
-    }
-    return true;
-}
-
-// --- Helper: assemble frames into an animated GIF using ImageMagick
-// fps → delay=100/fps (centiseconds per frame). 'optimize' lets ImageMagick reduce size.
-static bool assembleGif(const QString &magickBin,
-                        const QString &framesDir,
-                        int fps,
-                        const QString &outGif,
-                        bool optimize,
-                        QString *errOut)
-{
-    if (fps <= 0) fps = 12;
-    const int delayCs = qMax(1, 100 / fps); // centiseconds per frame, min 1
-
-    // Build arguments depending on whether we have "magick" or "convert"
-    QStringList args;
-    const bool isMagick7 = QFileInfo(magickBin).fileName() == "magick";
-
-    // Input glob
-    const QString glob = QDir(framesDir).filePath("frame_*.png");
-
-    if (isMagick7) {
-        // magick -delay XX -dispose Background -layers Optimize frame_*.png -loop 0 out.gif
-        args << "-delay" << QString::number(delayCs)
-             << "-dispose" << "Background";
-        if (optimize) args << "-layers" << "Optimize";
-        args << glob
-             << "-loop" << "0"
-             << outGif;
-    } else {
-        // convert (IM6)
-        args << "-delay" << QString::number(delayCs)
-             << "-dispose" << "Background";
-        if (optimize) args << "-layers" << "Optimize";
-        args << glob
-             << "-loop" << "0"
-             << outGif;
-    }
-
-    QProcess p;
-    if (isMagick7) {
-        p.start(magickBin, args);
-    } else {
-        // convert has no wrapper "magick", so we just run it directly
-        p.start(magickBin, args);
-    }
-    if (!p.waitForStarted(15000)) {
-        if (errOut) *errOut = "Failed to start ImageMagick.";
-        return false;
-    }
-    p.waitForFinished(-1);
-    const int exitCode = p.exitCode();
-    if (exitCode != 0) {
-        if (errOut) *errOut = QString("ImageMagick failed (exit %1): %2")
-                                  .arg(exitCode, 0, 10)
-                                  .arg(QString::fromUtf8(p.readAllStandardError()));
-        return false;
-    }
-    return true;
-}
-
-// Decide if we’re seeing the back for a given rotation angle.
-// Back is visible when cosine is negative -> angle in (90°, 270°)
-static inline bool isBackVisible(qreal angleDeg)
-{
-    qreal a = std::fmod(angleDeg, 360.0);
-    if (a < 0) a += 360.0;
-    return (a > 90.0 && a < 270.0);
-}
-
-// Resolve front & back QImages for this run (will auto-simulate the back if enabled or missing).
-bool MainWindow::resolveFrontBackImages(const QString &frontPath,
-                                        const QString &maybeBackPath,
-                                        QImage &frontOut,
-                                        QImage &backOut,
-                                        QString *errOut)
-{
-    if (frontPath.isEmpty()) {
-        if (errOut) *errOut = tr("No front image selected.");
-        return false;
-    }
-
-    QImage front(frontPath);
-    if (front.isNull()) {
-        if (errOut) *errOut = tr("Failed to load front image: %1").arg(frontPath);
-        return false;
-    }
-
-    // IMPORTANT: pass the required 3rd argument (simulateBack)
-    const bool simulateBack = simulateBacksideEnabled();
-    QString resolvedBack = ensureBackImageForRun(frontPath,
-                                                 maybeBackPath,
-                                                 simulateBack,
-                                                 errOut);
-
-    // If we didn’t get a back image (either not provided or simulation failed),
-    // fall back to single-sided rendering by using the front as the back.
-    // This keeps animations working instead of hard-failing.
-    QImage back;
-    if (!resolvedBack.isEmpty() && QFileInfo::exists(resolvedBack)) {
-        back.load(resolvedBack);
-        if (back.isNull()) {
-            if (errOut) *errOut = tr("Failed to load back image: %1").arg(resolvedBack);
-            // fallback: use front as back
-            back = front;
-        }
-    } else {
-        back = front;
-    }
-
-    // Normalize sizes so face swaps don’t “jump”
-    if (back.size() != front.size()) {
-        back = back.scaled(front.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-    }
-
-    frontOut = std::move(front);
-    backOut  = std::move(back);
-    return true;
-}
-
-// Pick which face to use at a given angle (works for both yaw-spin and pitch-flip).
-const QImage &MainWindow::pickFaceForAngle(const QImage &front,
-                                           const QImage &back,
-                                           qreal angleDeg) const
-{
-    return isBackVisible(angleDeg) ? back : front;
-}
-
-// Helper: Sample texture using bilinear interpolation at spherical coordinates
-// NOW with front/back hemisphere support
-QRgb MainWindow::sampleTexture(const QImage &frontTexture,
-                               const QImage &backTexture,
-                               qreal lon,
-                               qreal lat,
-                               const QColor &fallbackColor)
-{
-    // Determine which hemisphere we're in
-    const bool useFront = (lon >= -M_PI/2.0 && lon <= M_PI/2.0);
-    const QImage &texture = useFront ? frontTexture :
-                            (!backTexture.isNull() ? backTexture : frontTexture);
-
-    // If no texture available, use fallback color
-    if (texture.isNull()) return fallbackColor.rgba();
-
-    // Adjust longitude for back texture (remap to its own 0-width range)
-    qreal adjustedLon = lon;
-    if (!useFront && !backTexture.isNull()) {
-        adjustedLon = lon - M_PI;
-        if (adjustedLon < -M_PI) adjustedLon += 2.0 * M_PI;
-    }
-
-    // Convert lon/lat to texture coordinates
-    const qreal u = (adjustedLon + M_PI) / (2.0 * M_PI);  // 0 to 1
-    const qreal v = (lat + M_PI/2.0) / M_PI;              // 0 to 1
-
-    // Map to pixel coordinates
-    const qreal x = u * (texture.width() - 1);
-    const qreal y = v * (texture.height() - 1);
-
-    // Bilinear interpolation
-    const int x0 = qFloor(x);
-    const int y0 = qFloor(y);
-    const int x1 = qMin(x0 + 1, texture.width() - 1);
-    const int y1 = qMin(y0 + 1, texture.height() - 1);
-
-    const qreal fx = x - x0;
-    const qreal fy = y - y0;
-
-    const QRgb c00 = texture.pixel(x0, y0);
-    const QRgb c10 = texture.pixel(x1, y0);
-    const QRgb c01 = texture.pixel(x0, y1);
-    const QRgb c11 = texture.pixel(x1, y1);
-
-    // Check if this pixel has meaningful content (not just padding)
-    // If the texture has alpha, respect it; otherwise check if it's the fallback color
-    const int a00 = qAlpha(c00);
-    const int a10 = qAlpha(c10);
-    const int a01 = qAlpha(c01);
-    const int a11 = qAlpha(c11);
-
-    // If all corners are fully transparent, use fallback
-    if (texture.hasAlphaChannel() && a00 == 0 && a10 == 0 && a01 == 0 && a11 == 0) {
-        return fallbackColor.rgba();
-    }
-
-    // Interpolate each channel
-    const int r = qRound(
-        qRed(c00) * (1-fx) * (1-fy) +
-        qRed(c10) * fx * (1-fy) +
-        qRed(c01) * (1-fx) * fy +
-        qRed(c11) * fx * fy
-    );
-    const int g = qRound(
-        qGreen(c00) * (1-fx) * (1-fy) +
-        qGreen(c10) * fx * (1-fy) +
-        qGreen(c01) * (1-fx) * fy +
-        qGreen(c11) * fx * fy
-    );
-    const int b = qRound(
-        qBlue(c00) * (1-fx) * (1-fy) +
-        qBlue(c10) * fx * (1-fy) +
-        qBlue(c01) * (1-fx) * fy +
-        qBlue(c11) * fx * fy
-    );
-    const int a = qRound(
-        a00 * (1-fx) * (1-fy) +
-        a10 * fx * (1-fy) +
-        a01 * (1-fx) * fy +
-        a11 * fx * fy
-    );
-
-    return qRgba(r, g, b, a);
-}
-
-// Main globe generation function with backside and rotation axis support
-QImage MainWindow::renderGlobeFrame(const QImage &frontTexture,
-                                   const QImage &backTexture,
-                                   qreal rotationDegrees,
-                                   int sizePx,
-                                   const QColor &frameBg,
-                                   const QColor &globeSurfaceColor,
-                                   bool enableLighting,
-                                   int rotationAxis)
-{
-    QImage frame(sizePx, sizePx, QImage::Format_ARGB32_Premultiplied);
-    frame.fill(frameBg);  // Fill canvas with transparent (or chosen frame color)
-
-    if (frontTexture.isNull()) return frame;
-
-    const qreal radius = sizePx / 2.0;
-    const qreal centerX = sizePx / 2.0;
-    const qreal centerY = sizePx / 2.0;
-
-    const qreal rotRad = qDegreesToRadians(rotationDegrees);
-
-    // Render sphere using orthographic projection
-    for (int py = 0; py < sizePx; ++py) {
-        for (int px = 0; px < sizePx; ++px) {
-            const qreal x = px - centerX;
-            const qreal y = py - centerY;
-
-            const qreal distSq = x*x + y*y;
-            if (distSq > radius*radius) continue;
-
-            const qreal z = qSqrt(radius*radius - distSq);
-
-            qreal nx = x / radius;
-            qreal ny = y / radius;
-            qreal nz = z / radius;
-
-            // Apply rotation based on axis (your existing rotation code stays the same)
-            if (rotationAxis == 0) {
-                const qreal cosR = qCos(rotRad);
-                const qreal sinR = qSin(rotRad);
-                const qreal newNx = nx * cosR - nz * sinR;
-                const qreal newNz = nx * sinR + nz * cosR;
-                nx = newNx;
-                nz = newNz;
-            }
-            else if (rotationAxis == 1) {
-                const qreal cosR = qCos(rotRad);
-                const qreal sinR = qSin(rotRad);
-                const qreal newNy = ny * cosR - nz * sinR;
-                const qreal newNz = ny * sinR + nz * cosR;
-                ny = newNy;
-                nz = newNz;
-            }
-            else if (rotationAxis == 2) {
-                const qreal cosR = qCos(rotRad);
-                const qreal sinR = qSin(rotRad);
-                qreal newNx = nx * cosR - nz * sinR;
-                qreal newNz = nx * sinR + nz * cosR;
-
-                const qreal cosR2 = qCos(rotRad * 0.5);
-                const qreal sinR2 = qSin(rotRad * 0.5);
-                const qreal newNy = ny * cosR2 - newNz * sinR2;
-                newNz = ny * sinR2 + newNz * cosR2;
-
-                nx = newNx;
-                ny = newNy;
-                nz = newNz;
-            }
-
-            const qreal lat = qAsin(ny);
-            const qreal lon = qAtan2(nx, nz);
-
-            // Sample texture - use globeSurfaceColor for areas without texture
-
-        QRgb texColor = sampleTexture(frontTexture, backTexture, lon, lat, globeSurfaceColor);
-
-        // Apply lighting (preserve alpha channel!)
-        if (enableLighting) {
-            // Old (caused dull/grey back):
-            // const qreal lightDot = nz;
-            // const qreal brightness = qBound(0.3, lightDot, 1.0);
-
-            // New: symmetric + slightly brighter floor so the back isn't greyed out
-            const qreal lightDot = nz;
-            const qreal brightness = qBound(0.75, qAbs(lightDot), 1.0);
-
-            const int r = qRound(qRed(texColor)   * brightness);
-            const int g = qRound(qGreen(texColor) * brightness);
-            const int b = qRound(qBlue(texColor)  * brightness);
-            const int a = qAlpha(texColor); // PRESERVE alpha
-            texColor = qRgba(r, g, b, a);
-        }
-
-        frame.setPixel(px, py, texColor);
-        }
+    // Progress + Cancel for a running generation (hidden while idle)
+    m_progressBar = new QProgressBar(this);
+    m_progressBar->setMaximumWidth(200);
+    m_progressBar->hide();
+    m_btnCancel = new QPushButton(tr("Cancel"), this);
+    m_btnCancel->hide();
+    statusBar()->addPermanentWidget(m_progressBar);
+    statusBar()->addPermanentWidget(m_btnCancel);
+    connect(m_btnCancel, &QPushButton::clicked, this, &MainWindow::cancelGeneration);
+
+    // Extra output sizes: the same run also written at these sizes, next to
+    // the output as <name>_<px>.gif (rendered once, downscaled)
+    {
+        QSettings s("MyCompany", "GifMaker");
+        m_editOutputSizes = new QLineEdit(this);
+        m_editOutputSizes->setPlaceholderText(tr("Also: 128, 256"));
+        m_editOutputSizes->setToolTip(tr("More output sizes in px, written as <output>_<px>.gif from the same render"));
+        m_editOutputSizes->setText(s.value("outputSizes").toString());
+        if (ui->animSettingsLayout) ui->animSettingsLayout->addWidget(m_editOutputSizes);
+        connect(m_editOutputSizes, &QLineEdit::textChanged, this, [](const QString &text) {
+            QSettings s("MyCompany", "GifMaker");
+            s.setValue("outputSizes", text.trimmed());
+        });
     }
 
-    return frame;
-}
-
-// Simple L/R spin (yaw) with backside support.
-// Arguments you likely already pass in elsewhere:
-//  - frontPath, backPath: user-chosen paths (back may be empty)
-//  - outDir: where to write frames/GIF (this uses writeFrames on framesDir)
-//  - fps, durationSec: timing
-//  - maxAngleDeg: half-rotation amplitude (e.g., 180 for full spin, 90 for sway)
-//  - cycles: how many full cycles to perform
-bool MainWindow::generateSpinGif(const QString &frontPath,
-                                 const QString &backPath,
-                                 const QString &outDir,
-                                 int fps,
-                                 int durationSec,
-                                 qreal maxAngleDeg,
-                                 int cycles,
-                                 QString *errOut)
-{
-    QImage front, back;
-    if (!resolveFrontBackImages(frontPath, backPath, front, back, errOut))
-        return false;
-
-    const int totalFrames = qMax(1, fps * durationSec);
-    QList<QImage> frames;
-    frames.reserve(totalFrames);
-
-    // Base canvas: keep output size consistent
-    const QSize canvasSize = front.size();
-
-    // We'll sweep angle over cycles using a sine wave for smooth looping
-    // t in [0,1) -> angle = sin(t * 2π * cycles) * maxAngleDeg
-    for (int i = 0; i < totalFrames; ++i) {
-        const qreal t = static_cast<qreal>(i) / totalFrames;
-        const qreal angle = std::sin(t * 2.0 * M_PI * cycles) * maxAngleDeg;
-
-        // Choose which face to show at this yaw
-        const QImage &src = pickFaceForAngle(front, back, angle);
-
-        // Horizontal squash to fake perspective: scale factor ~ |cos(angle)|
-        const qreal cosA = std::abs(std::cos(qDegreesToRadians(angle)));
-        const int w = qMax(1, int(canvasSize.width() * cosA));
-        const int h = canvasSize.height();
-
-        QImage frame(canvasSize, QImage::Format_ARGB32_Premultiplied);
-        frame.fill(Qt::transparent);
+    setupLivePreview();
 
-        QPainter p(&frame);
-        p.setRenderHint(QPainter::SmoothPixmapTransform, true);
-
-        // Optionally add a subtle vertical scale for depth feeling
-        const qreal yScale = 0.98 + 0.02 * cosA; // ~1.0 at face-on, ~0.98 at edge-on
-        const int targetH = int(h * yScale);
-
-        // Center the squashed face on canvas
-        QRect target((canvasSize.width() - w) / 2,
-                     (canvasSize.height() - targetH) / 2,
-                     w, targetH);
-
-        p.drawImage(target, src);
-        p.end();
-
-        frames.push_back(std::move(frame));
-    }
-
-    // Write frames (your existing helper)
-    const QString framesDir = outDir; // If you use a subdir, adjust here
-    if (!writeFrames(frames, framesDir, errOut)) {
-        if (errOut && errOut->isEmpty())
-            *errOut = tr("Failed writing spin frames.");
-        return false;
-    }
-    return true;
+    connectUiActions();
 }
 
-// U/D flip (pitch) with backside support.
-// Similar parameters to generateSpinGif; flip amplitude is maxAngleDeg (e.g., 180 for full flips).
-bool MainWindow::generateFlipGif(const QString &frontPath,
-                                 const QString &backPath,
-                                 const QString &outDir,
-                                 int fps,
-                                 int durationSec,
-                                 qreal maxAngleDeg,
-                                 int cycles,
-                                 QString *errOut)
+MainWindow::~MainWindow()
 {
-    QImage front, back;
-    if (!resolveFrontBackImages(frontPath, backPath, front, back, errOut))
-        return false;
-
-    const int totalFrames = qMax(1, fps * durationSec);
-    QList<QImage> frames;
-    frames.reserve(totalFrames);
-
-    const QSize canvasSize = front.size();
-
-    for (int i = 0; i < totalFrames; ++i) {
-        const qreal t = static_cast<qreal>(i) / totalFrames;
-        const qreal angle = std::sin(t * 2.0 * M_PI * cycles) * maxAngleDeg;
-
-        // Choose which face to show at this pitch
-        const QImage &src = pickFaceForAngle(front, back, angle);
-
-        // Vertical squash ~ |cos(angle)|
-        const qreal cosA = std::abs(std::cos(qDegreesToRadians(angle)));
-        const int w = canvasSize.width();
-        const int h = qMax(1, int(canvasSize.height() * cosA));
-
-        QImage frame(canvasSize, QImage::Format_ARGB32_Premultiplied);
-        frame.fill(Qt::transparent);
-
-        QPainter p(&frame);
-        p.setRenderHint(QPainter::SmoothPixmapTransform, true);
-
-        // Optional slight x-scale for depth feeling
-        const qreal xScale = 0.98 + 0.02 * cosA;
-        const int targetW = int(w * xScale);
-
-        QRect target((canvasSize.width() - targetW) / 2,
-                     (canvasSize.height() - h) / 2,
-                     targetW, h);
-
-        p.drawImage(target, src);
-        p.end();
-
-        frames.push_back(std::move(frame));
+    // Don't leave a render running against a dead window
+    if (m_genThread) {
+        m_cancel = true;
+        m_genThread->wait();
+        delete m_genThread;
     }
-
-    const QString framesDir = outDir;
-    if (!writeFrames(frames, framesDir, errOut)) {
-        if (errOut && errOut->isEmpty())
-            *errOut = tr("Failed writing flip frames.");
-        return false;
+    if (m_previewThread) {
+        m_previewCancel = true;
+        m_previewThread->wait();
+        delete m_previewThread;
     }
-    return true;
+    delete ui;
 }
 
 // Call this once in your ctor AFTER ui->setupUi(this);
@@ -732,6 +179,32 @@ bool MainWindow::simulateBacksideEnabled() const
     return s.value("backfaceMode", 0).toInt() != 0; // 0=off
 }
 
+GifEngine MainWindow::makeEngine()
+{
+    GifEngine::Options opts;
+    opts.backImagePath = ui->editBackPath ? ui->editBackPath->text().trimmed() : QString();
+    opts.cropToContent = ui->checkCropToContent && ui->checkCropToContent->isChecked();
+
+    // Upside-down follows its radio if present, otherwise the saved mode (2)
+    bool upsideDown = false;
+    if (auto r = this->findChild<QRadioButton*>("radioSimBackfaceUpsideDown")) {
+        upsideDown = r->isChecked();
+    } else {
+        QSettings s("MyCompany", "GifMaker");
+        upsideDown = s.value("backfaceMode", 0).toInt() == 2;
+    }
+    opts.backsideMode = !simulateBacksideEnabled() ? GifEngine::BacksideOff
+                      : upsideDown                 ? GifEngine::BacksideUpsideDown
+                                                   : GifEngine::BacksideNormal;
+
+    GifEngine engine(opts);
+    // The engine may log from a worker thread; the statusbar lives on this one
+    engine.setLogger([this](const QString &msg) {
+        QMetaObject::invokeMethod(this, [this, msg] { appendLog(msg); }, Qt::QueuedConnection);
+    });
+    return engine;
+}
+
 // Auto-connected because it matches on_<objectName>_toggled(bool)
 void MainWindow::on_radioSimBackface_toggled(bool checked)
 {
@@ -741,90 +214,6 @@ void MainWindow::on_radioSimBackface_toggled(bool checked)
 }
 
 
-QImage MainWindow::makeBacksideFrom(const QImage &front, bool *ok, QString *errOut)
-{
-    if (ok) *ok = false;
-    if (front.isNull()) {
-        if (errOut) *errOut = QStringLiteral("Front image is empty.");
-        return {};
-    }
-
-    // Mirror horizontally (like viewing the back of a sticker)
-    QImage base = front.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-    QImage mirrored = base.mirrored(true, false);
-
-    // Subtle desaturation + slight darken
-    const qreal sat = 0.85;  // reduce colorfulness a bit
-    const qreal dim = 0.90;  // darken a touch
-
-    for (int y = 0; y < mirrored.height(); ++y) {
-        QRgb *scan = reinterpret_cast<QRgb*>(mirrored.scanLine(y));
-        for (int x = 0; x < mirrored.width(); ++x) {
-            const QRgb px = scan[x];
-            const int a = qAlpha(px);
-            int r = qRed(px), g = qGreen(px), b = qBlue(px);
-
-            const int gray = int(0.299 * r + 0.587 * g + 0.114 * b);
-            r = int(gray + (r - gray) * sat);
-            g = int(gray + (g - gray) * sat);
-            b = int(gray + (b - gray) * sat);
-
-            r = int(r * dim); if (r > 255) r = 255;
-            g = int(g * dim); if (g > 255) g = 255;
-            b = int(b * dim); if (b > 255) b = 255;
-
-            scan[x] = qRgba(r, g, b, a);
-        }
-    }
-
-    if (ok) *ok = true;
-    return mirrored;
-}
-
-QString MainWindow::ensureBackImageForRun(const QString &frontPath,
-                                          const QString &explicitBackPath,
-                                          bool simulateBack,
-                                          QString *errOut)
-{
-    // If user supplied a back image and we’re not forcing simulation, use it
-    if (!explicitBackPath.trimmed().isEmpty() && !simulateBack) {
-        if (!QFileInfo::exists(explicitBackPath)) {
-            if (errOut) *errOut = QStringLiteral("Back image does not exist: %1").arg(explicitBackPath);
-            return {};
-        }
-        return explicitBackPath;
-    }
-
-    // Simulate if requested, or if no explicit back provided (your choice)
-    if (!simulateBack && explicitBackPath.trimmed().isEmpty()) {
-        return {}; // single-sided
-    }
-
-    if (frontPath.trimmed().isEmpty() || !QFileInfo::exists(frontPath)) {
-        if (errOut) *errOut = QStringLiteral("Front image not set or missing; cannot simulate backside.");
-        return {};
-    }
-
-    QImage front(frontPath);
-    bool ok = false;
-    QString mkErr;
-    QImage back = makeBacksideFrom(front, &ok, &mkErr);
-    if (!ok || back.isNull()) {
-        if (errOut) *errOut = mkErr.isEmpty() ? QStringLiteral("Failed to generate backside.") : mkErr;
-        return {};
-    }
-
-    // Save to temp file so downstream code can just open a path
-    const QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-    QDir().mkpath(tempDir);
-    const QString outPath = QDir(tempDir).filePath(QStringLiteral("gifstew_back_sim.png"));
-    if (!back.save(outPath, "PNG")) {
-        if (errOut) *errOut = QStringLiteral("Could not save simulated backside to: %1").arg(outPath);
-        return {};
-    }
-    return outPath;
-}
-
 void MainWindow::setupBackfaceRadios()
 {
     // your radio names (use whichever you actually have)
@@ -889,573 +278,6 @@ void MainWindow::setupBackfaceRadios()
     hook(rUpside, 2);
 }
 
-// --- Main worker: spin (full 360°) over 'durationSec' at 'fps', output GIF.
-//    - srcImagePath: input still image
-//    - outGifPath:   absolute path to animated GIF
-//    - fps:          frames per second (e.g. 12, 24)
-//    - durationSec:  total duration (e.g. 2 → 2 seconds)
-//    - sizePx:       canvas size (square); image keeps aspect and is centered
-//    - bg:           background color (use Qt::transparent for alpha, or a solid color)
-// Returns true on success; on failure returns false and sets *errOut.
-bool MainWindow::generateSpinGif(const QString &srcImagePath,
-                                 const QString &outGifPath,
-                                 int fps,
-                                 int durationSec,
-                                 int sizePx,
-                                 const QColor &bg,
-                                 QString *errOut)
-{
-    if (!QFileInfo::exists(srcImagePath)) { if (errOut) *errOut="Source image does not exist."; return false; }
-    if (fps <= 0 || durationSec <= 0)     { if (errOut) *errOut="FPS and duration must be > 0."; return false; }
-
-    const QString magick = findImageMagick();
-    if (magick.isEmpty()) { if (errOut) *errOut="ImageMagick not found (sudo apt install imagemagick)."; return false; }
-
-    // Resolve/auto-simulate the back image if toggle is on or no explicit back provided
-    const QString userBackPath = ui->editBackPath ? ui->editBackPath->text().trimmed() : QString();
-    QString simErr;
-    const bool wantSim = simulateBacksideEnabled();
-    const QString resolvedBack = ensureBackImageForRun(srcImagePath, userBackPath, wantSim, &simErr);
-    if (wantSim && resolvedBack.isEmpty() && !simErr.isEmpty()) {
-        appendLog(QStringLiteral("Backside simulation failed: %1").arg(simErr));
-        // continue single-sided if we must
-    }
-
-    QImage src(srcImagePath);
-    if (src.isNull()) { if (errOut) *errOut="Failed to load source image."; return false; }
-
-    QImage back;
-    const bool haveBack = !resolvedBack.isEmpty()
-                       && QFileInfo::exists(resolvedBack)
-                       && back.load(resolvedBack);
-
-    if (sizePx < 32) sizePx = qMax(32, sizePx);
-    const QImage frontBase = makeSquareCanvas(src,  sizePx, bg);
-    const QImage backBase  = haveBack ? makeSquareCanvas(back, sizePx, bg) : frontBase;
-
-    const QSize canvasSize = frontBase.size();
-    const int totalFrames = fps * durationSec;
-    QList<QImage> frames; frames.reserve(totalFrames);
-
-    // Yaw spin: we sweep 0..360 degrees. When cos < 0, show the backside.
-    // Horizontal scale ~ |cos| with an epsilon so it never vanishes.
-    const qreal eps = 0.08;
-
-    for (int i=0;i<totalFrames;++i){
-        const qreal t   = (qreal)i / (qreal)totalFrames;
-        const qreal deg = 360.0 * t;
-        const qreal rad = qDegreesToRadians(deg);
-        const qreal c   = qCos(rad);
-
-        const bool showBack = (c < 0.0);
-        const qreal sxAbs   = (1.0 - eps) * std::abs(c) + eps; // width “thickness”
-
-        const QImage &face = showBack ? backBase : frontBase;
-
-        QImage frame(canvasSize, QImage::Format_ARGB32_Premultiplied);
-        frame.fill(bg);
-        QPainter p(&frame);
-        p.setRenderHint(QPainter::SmoothPixmapTransform,true);
-
-        // Optional slight vertical scale for depth feel near edge-on
-        const qreal yScale = 0.98 + 0.02 * std::abs(c);
-        const int targetW  = qMax(1, int(canvasSize.width() * sxAbs));
-        const int targetH  = qMax(1, int(canvasSize.height() * yScale));
-
-        const QRect target((canvasSize.width()  - targetW)/2,
-                           (canvasSize.height() - targetH)/2,
-                           targetW, targetH);
-
-        p.drawImage(target, face);
-        p.end();
-
-        frames.push_back(std::move(frame));
-    }
-
-    QTemporaryDir tmp("gif_spin_XXXXXX");
-    if (!tmp.isValid()){ if (errOut) *errOut="Could not create temp directory."; return false; }
-    const QString framesDir = QDir(tmp.path()).filePath("frames");
-    if (!writeFrames(frames, framesDir, errOut)) return false;
-    return assembleGif(magick, framesDir, fps, outGifPath, true, errOut);
-}
-
-// --- Variation: rotate back-and-forth (oscillate) by +/-maxDegrees
-bool MainWindow::generateOscillateGif(const QString &srcImagePath,
-                                      const QString &outGifPath,
-                                      int fps,
-                                      int durationSec,
-                                      int sizePx,
-                                      qreal maxDegrees,
-                                      const QColor &bg,
-                                      QString *errOut)
-{
-    if (!QFileInfo::exists(srcImagePath)) { if (errOut) *errOut="Source image does not exist."; return false; }
-    if (fps <= 0 || durationSec <= 0)     { if (errOut) *errOut="FPS and duration must be > 0."; return false; }
-
-    const QString magick = findImageMagick();
-    if (magick.isEmpty()) { if (errOut) *errOut="ImageMagick not found (sudo apt install imagemagick)."; return false; }
-
-    QImage src(srcImagePath); if (src.isNull()) { if (errOut) *errOut="Failed to load source image."; return false; }
-
-    const int totalFrames = fps * durationSec;
-    const QImage base = makeSquareCanvas(src, qMax(32,sizePx), bg);
-
-    const QPointF center(base.width()/2.0, base.height()/2.0);
-    const QRectF  dst(0.0, 0.0, base.width(), base.height());
-
-    QList<QImage> frames; frames.reserve(totalFrames);
-
-    for (int i=0;i<totalFrames;++i){
-        const qreal t   = (qreal)i / (qreal)totalFrames;
-        const qreal deg = maxDegrees * qSin(2.0*M_PI*t);
-
-        QImage frame(base.size(), QImage::Format_ARGB32_Premultiplied);
-        frame.fill(bg);
-        QPainter p(&frame);
-        p.setRenderHint(QPainter::SmoothPixmapTransform,true);
-
-        QTransform tr;                     // ← clean start
-        tr.translate(center.x(), center.y());
-        tr.rotate(deg);                    // ← only Z rotation, no shear
-        tr.translate(-center.x(), -center.y());
-        p.setTransform(tr);
-
-        p.drawImage(dst, base, base.rect());
-        p.end();
-        frames.push_back(std::move(frame));
-    }
-
-    QTemporaryDir tmp("gif_osc_XXXXXX"); if (!tmp.isValid()){ if (errOut) *errOut="Could not create temp directory."; return false; }
-    const QString framesDir = QDir(tmp.path()).filePath("frames");
-    if (!writeFrames(frames, framesDir, errOut)) return false;
-    return assembleGif(magick, framesDir, fps, outGifPath, true, errOut);
-}
-
-bool MainWindow::generateYawSpinGif(const QString &frontImagePath,
-                                    const QString &outGifPath,
-                                    int fps,
-                                    int durationSec,
-                                    int sizePx,
-                                    qreal rotations,          // interpreted as # of full rotations
-                                    const QColor &bg,
-                                    QString *errOut)
-{
-    const QString backImagePath = ui->editBackPath ? ui->editBackPath->text().trimmed() : QString();
-    const bool cropContent      = ui->checkCropToContent && ui->checkCropToContent->isChecked();
-
-    // Validate
-    if (!QFileInfo::exists(frontImagePath)) { if (errOut) *errOut = "Front image does not exist."; return false; }
-    if (fps <= 0 || durationSec <= 0)       { if (errOut) *errOut = "FPS and duration must be > 0."; return false; }
-    if (sizePx < 32) sizePx = 256;
-    if (rotations < 0) rotations = 0;
-
-    const QString magick = findImageMagick();
-    if (magick.isEmpty()) { if (errOut) *errOut = "ImageMagick not found (install imagemagick)."; return false; }
-
-    // Load
-    QImage front(frontImagePath);
-    if (front.isNull()) { if (errOut) *errOut = "Failed to load front image."; return false; }
-
-    QImage back;
-    const bool haveBack = !backImagePath.isEmpty() && QFileInfo::exists(backImagePath) && back.load(backImagePath);
-
-    // Optional crop-to-content
-    if (cropContent) {
-        front = cropToContentSmart(front);
-        if (haveBack) back = cropToContentSmart(back);
-    }
-
-    // Square-pad to desired size with bg, keeping aspect
-    const QImage frontBase = makeSquareCanvas(front, sizePx, bg);
-    const QImage backBase  = haveBack ? makeSquareCanvas(back,  sizePx, bg) : frontBase;
-
-    const int totalFrames = fps * durationSec;
-    if (totalFrames < 1) { if (errOut) *errOut = "Total frames computed < 1."; return false; }
-
-    const QPointF center(frontBase.width()/2.0, frontBase.height()/2.0);
-    const QRectF  dstRect(0.0, 0.0, frontBase.width(), frontBase.height());
-
-    QList<QImage> frames; frames.reserve(totalFrames);
-    const qreal eps = 0.08;
-
-    for (int i = 0; i < totalFrames; ++i) {
-        const qreal t      = (qreal)i / (qreal)totalFrames;
-        const qreal phiDeg = rotations * 360.0 * t;
-        const qreal c      = qCos(qDegreesToRadians(phiDeg));
-
-        const bool showBack = (c < 0.0);
-        const qreal sxAbs   = (1.0 - eps) * std::abs(c) + eps;
-        const QImage &face  = showBack ? backBase : frontBase;
-
-        QImage frame(frontBase.size(), QImage::Format_ARGB32_Premultiplied);
-        frame.fill(bg);
-
-        QPainter p(&frame);
-        p.setRenderHint(QPainter::SmoothPixmapTransform, true);
-
-        QTransform tr;
-        tr.translate(center.x(), center.y());
-        tr.scale(sxAbs, 1.0);   // no shear → no tilt
-        tr.translate(-center.x(), -center.y());
-        p.setTransform(tr);
-
-        p.drawImage(dstRect, face, face.rect());
-        p.end();
-
-        frames.push_back(std::move(frame));
-    }
-
-    QTemporaryDir tmp("gif_yaw_XXXXXX");
-    if (!tmp.isValid()) { if (errOut) *errOut = "Could not create temp directory."; return false; }
-    const QString framesDir = QDir(tmp.path()).filePath("frames");
-    if (!writeFrames(frames, framesDir, errOut)) return false;
-    return assembleGif(magick, framesDir, fps, outGifPath, true, errOut);
-}
-
-bool MainWindow::generateFlipGif(const QString &frontImagePath,
-                                 const QString &outGifPath,
-                                 int fps,
-                                 int durationSec,
-                                 int sizePx,
-                                 bool animate,
-                                 int cycles,
-                                 const QColor &bg,
-                                 QString *errOut)
-{
-    const QString userBackPath = ui->editBackPath ? ui->editBackPath->text().trimmed() : QString();
-
-    if (!QFileInfo::exists(frontImagePath)) { if (errOut) *errOut="Front image does not exist."; return false; }
-    if (fps <= 0 || durationSec <= 0)       { if (errOut) *errOut="FPS and duration must be > 0."; return false; }
-    if (sizePx < 32) sizePx = 256;
-
-    const QString magick = findImageMagick();
-    if (magick.isEmpty()) { if (errOut) *errOut="ImageMagick not found (install imagemagick)."; return false; }
-
-    // Resolve/auto-simulate the back image when toggle is ON or missing explicit back
-    QString simErr;
-    const bool wantSim = simulateBacksideEnabled();
-    const QString resolvedBack = ensureBackImageForRun(frontImagePath, userBackPath, wantSim, &simErr);
-    if (wantSim && resolvedBack.isEmpty() && !simErr.isEmpty()) {
-        appendLog(QStringLiteral("Backside simulation failed: %1").arg(simErr));
-        // continue single-sided if we must
-    }
-
-    QImage front(frontImagePath);
-    if (front.isNull()) { if (errOut) *errOut="Failed to load front image."; return false; }
-
-    QImage back;
-    const bool haveBack = !resolvedBack.isEmpty()
-                          && QFileInfo::exists(resolvedBack)
-                          && back.load(resolvedBack);
-
-    // Square canvases
-    const QImage frontBase = makeSquareCanvas(front, sizePx, bg);
-    const QImage backBase  = haveBack ? makeSquareCanvas(back,  sizePx, bg) : frontBase;
-
-    // Should the *flip* show the backside upside down?
-    const auto upsideDownSelected = [this]() -> bool {
-        if (auto r = this->findChild<QRadioButton*>("radioSimBackfaceUpsideDown"))
-            return r->isChecked();
-        QSettings s("MyCompany", "GifMaker");
-        return s.value("backfaceMode", 0).toInt() == 2; // 2 = upside-down
-    };
-    const QImage backForFlip = upsideDownSelected() ? backBase.mirrored(true, true) : backBase;
-
-    const QPointF center(frontBase.width()/2.0, frontBase.height()/2.0);
-    const QRectF  dst(0.0, 0.0, frontBase.width(), frontBase.height());
-
-    // Non-animated “flip”: just show back (respecting upside-down if selected), else front
-    if (!animate) {
-        const QImage &face = haveBack ? backForFlip : frontBase;
-
-        QImage frame(frontBase.size(), QImage::Format_ARGB32_Premultiplied);
-        frame.fill(bg);
-        QPainter p(&frame);
-        p.setRenderHint(QPainter::SmoothPixmapTransform,true);
-        p.drawImage(dst, face, face.rect());
-        p.end();
-
-        QList<QImage> frames; frames.push_back(std::move(frame));
-        QTemporaryDir tmp("gif_flip_XXXXXX");
-        if (!tmp.isValid()){ if (errOut) *errOut="Could not create temp directory."; return false; }
-        const QString framesDir = QDir(tmp.path()).filePath("frames");
-        if (!writeFrames(frames, framesDir, errOut)) return false;
-        return assembleGif(magick, framesDir, fps, outGifPath, true, errOut);
-    }
-
-    // Animated flip with backside: vertical thickness + swap face when cos < 0
-    const int totalFrames = fps * durationSec;
-    if (totalFrames < 1) { if (errOut) *errOut = "Total frames computed < 1."; return false; }
-
-    const qreal eps = 0.08; // thickness floor so it never vanishes
-    QList<QImage> frames; frames.reserve(totalFrames);
-
-    for (int i=0;i<totalFrames;++i){
-        const qreal t   = (qreal)i / (qreal)totalFrames;
-        const qreal phi = 2.0 * M_PI * qMax(1, cycles) * t;
-
-        const qreal c   = qCos(phi);
-        const bool showBack = (c < 0.0);
-        const qreal syAbs  = (1.0 - eps) * std::abs(c) + eps; // vertical “thickness”
-        const QImage &face = showBack ? backForFlip : frontBase;
-
-        QImage frame(frontBase.size(), QImage::Format_ARGB32_Premultiplied);
-        frame.fill(bg);
-        QPainter p(&frame);
-        p.setRenderHint(QPainter::SmoothPixmapTransform,true);
-
-        QTransform tr;
-        tr.translate(center.x(), center.y());
-        tr.scale(1.0, syAbs); // NO SHEAR → no tilt
-        tr.translate(-center.x(), -center.y());
-        p.setTransform(tr);
-
-        p.drawImage(dst, face, face.rect());
-        p.end();
-        frames.push_back(std::move(frame));
-    }
-
-    QTemporaryDir tmp("gif_flip_XXXXXX");
-    if (!tmp.isValid()){ if (errOut) *errOut="Could not create temp directory."; return false; }
-    const QString framesDir = QDir(tmp.path()).filePath("frames");
-    if (!writeFrames(frames, framesDir, errOut)) return false;
-    return assembleGif(magick, framesDir, fps, outGifPath, true, errOut);
-}
-
-bool MainWindow::generateCompositeGif(const QString &frontImagePath,
-                                      const QString &outGifPath,
-                                      int fps,
-                                      int durationSec,
-                                      int sizePx,
-                                      bool useZSpin,
-                                      qreal zDegPerSec,
-                                      bool useYaw,
-                                      qreal maxYawRotations,   // your UI uses rotations count here
-                                      bool useFlip,
-                                      bool flipAnimate,
-                                      int flipCycles,
-                                      const QColor &bg,
-                                      QString *errOut)
-{
-    const QString userBackPath = ui->editBackPath ? ui->editBackPath->text().trimmed() : QString();
-    const bool cropContent      = ui->checkCropToContent && ui->checkCropToContent->isChecked();
-
-    if (!QFileInfo::exists(frontImagePath)) { if (errOut) *errOut="Front image does not exist."; return false; }
-    if (fps <= 0 || durationSec <= 0)       { if (errOut) *errOut="FPS and duration must be > 0."; return false; }
-    if (sizePx < 32) sizePx = 256;
-
-    const QString magick = findImageMagick();
-    if (magick.isEmpty()) { if (errOut) *errOut="ImageMagick not found (install imagemagick)."; return false; }
-
-    // Load
-    QImage front(frontImagePath);
-    if (front.isNull()) { if (errOut) *errOut="Failed to load front image."; return false; }
-
-    // Resolve/auto-simulate backside
-    QString simErr;
-    const bool wantSim = simulateBacksideEnabled();
-    const QString resolvedBack = ensureBackImageForRun(frontImagePath, userBackPath, wantSim, &simErr);
-    if (wantSim && resolvedBack.isEmpty() && !simErr.isEmpty()) {
-        appendLog(QStringLiteral("Backside simulation failed: %1").arg(simErr));
-        // continue single-sided if needed
-    }
-
-    QImage back;
-    const bool haveBack = !resolvedBack.isEmpty()
-                          && QFileInfo::exists(resolvedBack)
-                          && back.load(resolvedBack);
-
-    // Optional crop-to-content
-    if (cropContent) {
-        front = cropToContentSmart(front);
-        if (haveBack) back = cropToContentSmart(back);
-    }
-
-    // Canvases
-    QImage frontBase = makeSquareCanvas(front, sizePx, bg);
-    QImage backBase  = haveBack ? makeSquareCanvas(back,  sizePx, bg) : frontBase;
-
-    // Upside-down only for FLIP backs
-    const auto upsideDownSelected = [this]() -> bool {
-        if (auto r = this->findChild<QRadioButton*>("radioSimBackfaceUpsideDown"))
-            return r->isChecked();
-        QSettings s("MyCompany", "GifMaker");
-        return s.value("backfaceMode", 0).toInt() == 2; // 2 = upside-down
-    };
-    const QImage backForFlip = upsideDownSelected() ? backBase.mirrored(true, true) : backBase;
-
-    const QSize  canvasSize = frontBase.size();
-    const QPointF center(canvasSize.width()/2.0, canvasSize.height()/2.0);
-    const QRectF  dst(0.0, 0.0, canvasSize.width(), canvasSize.height());
-
-    // Frames
-    const int totalFrames = fps * durationSec;
-    if (totalFrames < 1) { if (errOut) *errOut = "Total frames computed < 1."; return false; }
-
-    const qreal eps = 0.08; // thickness floors
-    QList<QImage> frames; frames.reserve(totalFrames);
-
-    for (int i=0;i<totalFrames;++i) {
-        const qreal t01 = (qreal)i / (qreal)totalFrames;
-
-        // Z spin angle
-        const qreal zDeg = useZSpin ? (zDegPerSec * (t01 * durationSec)) : 0.0;
-
-        // Yaw → which side due to spin?
-        bool  yawBack = false;
-        qreal sxAbs   = 1.0;
-        if (useYaw) {
-            const qreal cx = qCos(2.0 * M_PI * qMax<qreal>(0.0, maxYawRotations) * t01);
-            yawBack = (cx < 0.0);
-            sxAbs   = (1.0 - eps) * std::abs(cx) + eps;   // horizontal “thickness”
-        }
-
-        // Flip → which side due to flip?
-        bool  flipBack = false;
-        qreal syAbs    = 1.0;
-        if (useFlip) {
-            if (!flipAnimate) {
-                flipBack = true; // static “show back”
-            } else {
-                const qreal phi = 2.0 * M_PI * qMax(1, flipCycles) * t01;
-                const qreal cy  = qCos(phi);
-                flipBack = (cy < 0.0);
-                syAbs    = (1.0 - eps) * std::abs(cy) + eps; // vertical “thickness”
-            }
-        }
-
-        // Back shown iff exactly one axis says “back”
-        const bool showBack = (yawBack ^ flipBack);
-
-        // Choose which back to use based on WHY we’re showing it:
-        // - if back is from FLIP -> use upside-down option
-        // - if back is from YAW -> use normal back
-        const QImage &face = showBack
-                           ? ((flipBack && !yawBack) ? backForFlip : backBase)
-                           : frontBase;
-
-        QImage frame(canvasSize, QImage::Format_ARGB32_Premultiplied);
-        frame.fill(bg);
-
-        QPainter p(&frame);
-        p.setRenderHint(QPainter::SmoothPixmapTransform, true);
-        p.setRenderHint(QPainter::Antialiasing, true);
-
-        QTransform tr;
-        tr.translate(center.x(), center.y());
-        if (useZSpin) tr.rotate(zDeg);
-        tr.scale(sxAbs, syAbs);
-        tr.translate(-center.x(), -center.y());
-        p.setTransform(tr);
-
-        p.drawImage(dst, face, face.rect());
-        p.end();
-
-        frames.push_back(std::move(frame));
-    }
-
-    QTemporaryDir tmp("gif_combo_XXXXXX");
-    if (!tmp.isValid()) { if (errOut) *errOut="Could not create temp directory."; return false; }
-    const QString framesDir = QDir(tmp.path()).filePath("frames");
-    if (!writeFrames(frames, framesDir, errOut)) return false;
-    return assembleGif(magick, framesDir, fps, outGifPath, true, errOut);
-}
-
-// Main globe generation function with backside and rotation axis support
-bool MainWindow::generateGlobeGif(const QString &frontImagePath,
-                                 const QString &backImagePath,
-                                 const QString &outGifPath,
-                                 int fps,
-                                 int durationSec,
-                                 int sizePx,
-                                 qreal rotationSpeed,
-                                 qreal zoomPercent,
-                                 int rotationAxis,
-                                 const QColor &globeSurfaceColor,
-                                 QString *errOut)
-{
-    // Validate inputs
-    if (frontImagePath.isEmpty()) {
-        if (errOut) *errOut = "No front image path provided.";
-        return false;
-    }
-    if (!QFileInfo::exists(frontImagePath)) {
-        if (errOut) *errOut = "Front image does not exist.";
-        return false;
-    }
-    if (fps <= 0 || durationSec <= 0) {
-        if (errOut) *errOut = "FPS and duration must be > 0.";
-        return false;
-    }
-    if (sizePx < 64) sizePx = 512;
-
-    const QString magick = findImageMagick();
-    if (magick.isEmpty()) {
-        if (errOut) *errOut = "ImageMagick not found (install imagemagick).";
-        return false;
-    }
-
-    // Load front texture
-    QImage frontTexture(frontImagePath);
-    if (frontTexture.isNull()) {
-        if (errOut) *errOut = "Failed to load front texture image.";
-        return false;
-    }
-    frontTexture = frontTexture.convertToFormat(QImage::Format_ARGB32);
-
-    // Load back texture (optional)
-    QImage backTexture;
-    if (!backImagePath.isEmpty() && QFileInfo::exists(backImagePath)) {
-        backTexture = QImage(backImagePath);
-        if (!backTexture.isNull()) {
-            backTexture = backTexture.convertToFormat(QImage::Format_ARGB32);
-        }
-    }
-
-    // Apply zoom to both textures
-    if (qAbs(zoomPercent - 100.0) > 0.1) {
-        frontTexture = zoomImage(frontTexture, zoomPercent, globeSurfaceColor);
-        if (!backTexture.isNull()) {
-            backTexture = zoomImage(backTexture, zoomPercent, globeSurfaceColor);
-        }
-    }
-
-    // Calculate frames
-    const int totalFrames = fps * durationSec;
-    if (totalFrames < 1) {
-        if (errOut) *errOut = "Total frames computed < 1.";
-        return false;
-    }
-
-    const qreal degreesPerFrame = (rotationSpeed * 360.0) / totalFrames;
-
-    QList<QImage> frames;
-    frames.reserve(totalFrames);
-
-    // Always use transparent background for the frame canvas
-    const QColor frameBackground = Qt::transparent;
-
-    // Generate each frame
-    for (int i = 0; i < totalFrames; ++i) {
-        const qreal rotation = i * degreesPerFrame;
-        QImage frame = renderGlobeFrame(frontTexture, backTexture, rotation,
-                                       sizePx, frameBackground, globeSurfaceColor,
-                                       true, rotationAxis);
-        frames.push_back(std::move(frame));
-    }
-
-    // Write frames and assemble GIF
-    QTemporaryDir tmp("gif_globe_XXXXXX");
-    if (!tmp.isValid()) {
-        if (errOut) *errOut = "Could not create temp directory.";
-        return false;
-    }
-
-    const QString framesDir = QDir(tmp.path()).filePath("frames");
-    if (!writeFrames(frames, framesDir, errOut)) return false;
-    return assembleGif(magick, framesDir, fps, outGifPath, true, errOut);
-}
-
 void MainWindow::appendLog(const QString &msg)
 {
     if (auto sb = this->statusBar()) {
@@ -1623,29 +445,22 @@ QString MainWindow::pickImageWithPreview(const QString &startDir)
     return {};
 }
 
-void MainWindow::on_btnGenerate_clicked()
+// Generator call for the current UI settings, writing 'out'. Everything is
+// captured by value so it can run on a worker thread. sizeOverride/maxFps
+// (when > 0) shrink it for the live preview.
+std::function<bool(GifEngine &, QString *)> MainWindow::makeRun(const QString &src, const QString &out,
+                                                                int sizeOverride, int maxFps) const
 {
-    // Paths
-    const QString src = ui->editImagePath ? ui->editImagePath->text().trimmed() : QString();
-    const QString out = ui->editOutputPath ? ui->editOutputPath->text().trimmed() : QString();
-
-    if (src.isEmpty() || !QFileInfo::exists(src)) {
-        QMessageBox::warning(this, tr("Missing Image"), tr("Please choose a valid source image."));
-        return;
-    }
-    if (out.isEmpty()) {
-        QMessageBox::warning(this, tr("Missing Output"), tr("Please choose an output GIF filename."));
-        return;
-    }
-
-    // Common params
-    const int   fps           = ui->spinFPS      ? ui->spinFPS->value()      : 24;
-    const int   sizePx        = ui->spinSizePx   ? ui->spinSizePx->value()   : 512;
-
-    // FRACTIONAL seconds per revolution (allow < 1s/rev)
+    // Common params (the preview overrides size and caps fps)
+    int fps    = ui->spinFPS    ? ui->spinFPS->value()    : 24;
+    int sizePx = ui->spinSizePx ? ui->spinSizePx->value() : 512;
+    if (sizeOverride > 0) sizePx = sizeOverride;
+    if (maxFps > 0)       fps    = qMin(fps, maxFps);
+
+    // FRACTIONAL seconds per revolution (allow < 1s/rev), snapped to whole
+    // frames so one revolution is exactly the run and the loop has no seam
     const double durationSecF = ui->spinDuration ? qMax(0.10, ui->spinDuration->value()) : 1.0;
-    // Some existing generators might still take an int duration; keep it safe (≥1)
-    const int    durationSec  = qMax(1, int(std::ceil(durationSecF)));
+    const double durationSec  = GifEngine::frameCount(fps, durationSecF) / double(fps);
 
     QColor bg = Qt::transparent;
     if (ui->comboBackground) {
@@ -1667,25 +482,14 @@ void MainWindow::on_btnGenerate_clicked()
     const int   flipCycles   = ui->spinYawMax_2 ? qMax(1, (int)ui->spinYawMax_2->value())   : 1;
 
     // >>> Speed derived from FRACTIONAL seconds per revolution
-    const double zDegPerSec = 360.0 / durationSecF;   // e.g., 0.5s/rev => 720 deg/sec (fast!)
+    const double zDegPerSec = 360.0 / durationSec;    // e.g., 0.5s/rev => 720 deg/sec (fast!)
 
-    QString err;
-    bool ok = false;
+    std::function<bool(GifEngine &, QString *)> run;
 
     if (wantGlobe) {
         const qreal rotations   = ui->spinGlobeRotations ? ui->spinGlobeRotations->value() : 1.0;
         const qreal zoomPercent = ui->spinGlobeZoom      ? ui->spinGlobeZoom->value()      : 100.0;
 
-        // NEW: resolve the back image for this run (user-provided OR simulated)
-        QString simErr;
-        const QString userBack  = ui->editBackPath ? ui->editBackPath->text().trimmed() : QString();
-        const bool    wantSim   = simulateBacksideEnabled();
-        const QString backPath  = ensureBackImageForRun(src, userBack, wantSim, &simErr);
-        if (wantSim && backPath.isEmpty() && !simErr.isEmpty()) {
-            appendLog(QStringLiteral("Backside simulation failed: %1").arg(simErr));
-            // continue single-sided (generateGlobeGif handles empty back path)
-        }
-
         int axis = 0;
         if (ui->comboGlobeAxis) {
             const QString axisText = ui->comboGlobeAxis->currentText();
@@ -1693,39 +497,188 @@ void MainWindow::on_btnGenerate_clicked()
             else if (axisText.contains("Both", Qt::CaseInsensitive)) axis = 2;
         }
 
-        // bg is used for globe surface color, frame is always transparent
-        ok = generateGlobeGif(src, backPath, out, fps, durationSec, sizePx,
-                              rotations, zoomPercent, axis, bg, &err);
+        run = [=](GifEngine &engine, QString *err) {
+            // No back path: the engine uses the run's back face (user-provided
+            // OR simulated, in memory), or renders single-sided.
+            // bg is used for globe surface color, frame is always transparent
+            return engine.generateGlobeGif(src, QString(), out, fps, durationSec, sizePx,
+                                           rotations, zoomPercent, axis, bg, err);
+        };
 
     } else {
         const int modeCount = int(wantZSpin) + int(wantYaw) + int(wantFlip);
 
         // Use the composite path for 1+ primary directions so we can honor zDegPerSec precisely.
         if (modeCount >= 1) {
-            ok = generateCompositeGif(src, out, fps, durationSec /*int for legacy*/, sizePx,
-                                      wantZSpin, zDegPerSec,
-                                      wantYaw,   yawRotations,
-                                      wantFlip,  flipAnimate, flipCycles,
-                                      bg, &err);
+            run = [=](GifEngine &engine, QString *err) {
+                return engine.generateCompositeGif(src, out, fps, durationSec, sizePx,
+                                                   wantZSpin, zDegPerSec,
+                                                   wantYaw,   yawRotations,
+                                                   wantFlip,  flipAnimate, flipCycles,
+                                                   bg, err);
+            };
         }
         else if (wantOsc) {
             const qreal maxDeg = ui->spinMaxDegrees ? ui->spinMaxDegrees->value() : 15.0;
-            ok = generateOscillateGif(src, out, fps, durationSec /*int*/, sizePx, maxDeg, bg, &err);
-        }
-        else {
-            QMessageBox::warning(this, tr("No Mode Selected"),
-                                 tr("Choose Spin, Yaw, Flip, Oscillate, or Globe."));
-            return;
+            run = [=](GifEngine &engine, QString *err) {
+                return engine.generateOscillateGif(src, out, fps, durationSec, sizePx, maxDeg, bg, err);
+            };
         }
     }
 
-    if (!ok) {
-        QMessageBox::critical(this, tr("GIF Generation Failed"), err);
+    return run;   // empty when no mode is selected
+}
+
+void MainWindow::on_btnGenerate_clicked()
+{
+    // Paths
+    const QString src = ui->editImagePath ? ui->editImagePath->text().trimmed() : QString();
+    const QString out = ui->editOutputPath ? ui->editOutputPath->text().trimmed() : QString();
+
+    if (src.isEmpty() || !QFileInfo::exists(src)) {
+        QMessageBox::warning(this, tr("Missing Image"), tr("Please choose a valid source image."));
         return;
     }
+    if (out.isEmpty()) {
+        QMessageBox::warning(this, tr("Missing Output"), tr("Please choose an output GIF filename."));
+        return;
+    }
+
+    // The run itself goes to a worker thread, so it captures everything by value
+    const std::function<bool(GifEngine &, QString *)> run = makeRun(src, out);
+    if (!run) {
+        QMessageBox::warning(this, tr("No Mode Selected"),
+                             tr("Choose Spin, Yaw, Flip, Oscillate, or Globe."));
+        return;
+    }
+
+    bool sizesOk = true;
+    GifEngine::parseSizeList(m_editOutputSizes ? m_editOutputSizes->text() : QString(), &sizesOk);
+    if (!sizesOk) {
+        QMessageBox::warning(this, tr("Invalid Sizes"),
+                             tr("Extra output sizes must be pixel sizes from 16 to 4096, e.g. \"128, 256\"."));
+        return;
+    }
+
+    startGeneration(run, out);
+}
+
+// Runs 'run' on a worker thread; the window stays responsive, progress goes
+// to the statusbar and the Cancel button stops it within a frame.
+void MainWindow::startGeneration(const std::function<bool(GifEngine &, QString *)> &run,
+                                 const QString &outGifPath)
+{
+    // The full render gets the cores; the proxy keeps playing until it is done
+    m_previewCancel = true;
+    m_previewPending = false;
+
+    GifEngine engine = makeEngine();
+    // Extra sizes are for the real output only, never the preview proxy
+    GifEngine::Options opts = engine.options();
+    opts.outputSizes = GifEngine::parseSizeList(m_editOutputSizes ? m_editOutputSizes->text() : QString());
+    engine.setOptions(opts);
+    m_cancel = false;
+    engine.setCancelFlag(&m_cancel);
+    {
+        QSettings s("MyCompany", "GifMaker");
+        m_genProfile.setTracing(s.value("profileTrace", false).toBool()
+                                && !s.value("profileReportDir").toString().isEmpty());
+    }
+    m_genProfile.reset();
+    engine.setProfile(&m_genProfile);
+    engine.setProgress([this](int done, int total) {
+        QMetaObject::invokeMethod(this, [this, done, total] { showProgress(done, total); },
+                                  Qt::QueuedConnection);
+    });
+
+    m_genOk = false;
+    m_genError.clear();
+    m_genThread = QThread::create([this, engine, run]() mutable {
+        QString err;
+        const bool ok = run(engine, &err);
+        // Read by finishGeneration() once the thread has finished
+        m_genOk     = ok;
+        m_genError  = err;
+        m_genFrames = engine.lastFrameCount();
+    });
+    connect(m_genThread, &QThread::finished, this, [this, outGifPath] { finishGeneration(outGifPath); });
+
+    setGenerating(true);
+    m_genThread->start();
+}
+
+void MainWindow::finishGeneration(const QString &outGifPath)
+{
+    m_genThread->wait();
+    delete m_genThread;
+    m_genThread = nullptr;
+    setGenerating(false);
+
+    // Per-job timing report for monitoring, when a folder is configured
+    // (plus the render timeline with "profileTrace")
+    m_genProfile.stop();
+    QSettings s("MyCompany", "GifMaker");
+    const QString reportDir = s.value("profileReportDir").toString();
+    if (!reportDir.isEmpty()) {
+        QJsonObject info;
+        info.insert("output", outGifPath);
+        info.insert("ok", m_genOk);
+        if (!m_genOk) info.insert("error", m_cancel ? tr("Cancelled.") : m_genError);
+        info.insert("frames", m_genFrames);
+        QDir().mkpath(reportDir);
+        const QString name = QFileInfo(outGifPath).completeBaseName() + ".json";
+        QString reportErr;
+        if (!m_genProfile.writeJson(QDir(reportDir).filePath(name), info, &reportErr))
+            qDebug().noquote() << "[GIFStew]" << reportErr;
+        const QString traceName = QFileInfo(outGifPath).completeBaseName() + ".trace.json";
+        if (m_genProfile.isTracing()
+            && !m_genProfile.writeTrace(QDir(reportDir).filePath(traceName), &reportErr))
+            qDebug().noquote() << "[GIFStew]" << reportErr;
+    }
+
+    if (!m_genOk) {
+        // Cancelled runs leave no output behind; nothing to report but that
+        if (m_cancel) appendLog(tr("Generation cancelled."));
+        else          QMessageBox::critical(this, tr("GIF Generation Failed"), m_genError);
+        return;
+    }
+
+    appendLog(tr("Saved %1").arg(outGifPath));
+    appendLog(m_genProfile.summary());
 
     // Show the result in the preview
-    showGifInPreview(out);
+    showGifInPreview(outGifPath);
+}
+
+void MainWindow::cancelGeneration()
+{
+    if (!m_genThread) return;
+    m_cancel = true;
+    m_btnCancel->setEnabled(false);
+    statusBar()->showMessage(tr("Cancelling…"));
+}
+
+void MainWindow::setGenerating(bool on)
+{
+    if (ui->btnGenerate) ui->btnGenerate->setEnabled(!on);
+    m_progressBar->setRange(0, 0);   // busy until the first frame is written
+    m_progressBar->setVisible(on);
+    m_btnCancel->setEnabled(on);
+    m_btnCancel->setVisible(on);
+    if (on) statusBar()->showMessage(tr("Rendering…"));
+    else    statusBar()->clearMessage();
+}
+
+void MainWindow::showProgress(int done, int total)
+{
+    if (!m_genThread || m_cancel) return;
+    if (total > 0) {
+        m_progressBar->setRange(0, total);
+        m_progressBar->setValue(done);
+        statusBar()->showMessage(tr("Rendering frame %1 of %2").arg(done).arg(total));
+    } else {
+        statusBar()->showMessage(tr("Rendering frame %1").arg(done));
+    }
 }
 
 // Browse for source image → fills duration and suggests an output name
@@ -1864,6 +817,8 @@ void MainWindow::showGifInPreview(const QString &gifPath)
     if (!ui->lblPreview) return;
     if (!QFileInfo::exists(gifPath)) return;
 
+    if (m_previewPlayer) m_previewPlayer->stop();
+
     // Clean up any previous movie
     if (auto *old = ui->lblPreview->movie()) {
         old->stop();
@@ -1903,56 +858,6 @@ void MainWindow::showGifInPreview(const QString &gifPath)
 }
 
 
-// Helper: Zoom image
-// New behavior:
-//   <100%  = shrink image and pad to original size (appears smaller on globe)
-//   100%   = unchanged
-//   >100%  = crop central region (appears larger on globe)
-QImage MainWindow::zoomImage(const QImage &src, qreal zoomPercent, const QColor &padColor)
-{
-    if (src.isNull()) return src;
-
-    // Treat ~100% as "no change"
-    if (qAbs(zoomPercent - 100.0) < 0.1) return src;
-
-    // Safety clamps
-    if (zoomPercent <= 0.0) zoomPercent = 1.0;
-
-    if (zoomPercent > 100.0) {
-        // ZOOM IN (make features larger on the globe):
-        // keep only the central portion of the texture (crop)
-        // e.g. 200% -> keep 50% width/height centered
-        const qreal keep = 100.0 / zoomPercent;         // fraction of original to keep
-        const int newW   = qMax(1, qRound(src.width()  * keep));
-        const int newH   = qMax(1, qRound(src.height() * keep));
-        const int x      = (src.width()  - newW) / 2;
-        const int y      = (src.height() - newH) / 2;
-
-        // Return the cropped texture; the sampler maps the smaller image across the sphere,
-        // which effectively enlarges features.
-        return src.copy(x, y, newW, newH);
-    } else {
-        // ZOOM OUT (make features smaller on the globe):
-        // scale the image down, then center it on a canvas the original size
-        const qreal scale = zoomPercent / 100.0;        // e.g. 50% -> 0.5 scale
-        const int newW    = qMax(1, qRound(src.width()  * scale));
-        const int newH    = qMax(1, qRound(src.height() * scale));
-
-        QImage result(src.width(), src.height(), QImage::Format_ARGB32);
-        result.fill(padColor);
-
-        QImage scaled = src.scaled(newW, newH, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        const int x   = (src.width()  - scaled.width())  / 2;
-        const int y   = (src.height() - scaled.height()) / 2;
-
-        QPainter p(&result);
-        p.drawImage(x, y, scaled);
-        p.end();
-
-        return result;
-    }
-}
-
 void MainWindow::connectUiActions()
 {
     constexpr auto UC = Qt::UniqueConnection;
@@ -1981,3 +886,140 @@ void MainWindow::connectUiActions()
         QObject::connect(ui->btnGenerate, &QPushButton::clicked,
                          this, &MainWindow::on_btnGenerate_clicked, UC);
 }
+
+// --- Live preview ------------------------------------------------------------
+
+// Proxy size and frame-rate cap: small enough to re-render while tuning
+static const int kPreviewSizePx     = 128;
+static const int kPreviewMaxFps     = 12;
+static const int kPreviewDisplayPx  = 256;
+static const int kPreviewDebounceMs = 200;
+
+void MainWindow::setupLivePreview()
+{
+    QSettings s("MyCompany", "GifMaker");
+
+    m_chkLivePreview = new QCheckBox(tr("Live preview"), this);
+    m_chkLivePreview->setChecked(s.value("livePreview", false).toBool());
+    if (ui->previewLayout) ui->previewLayout->addWidget(m_chkLivePreview);
+
+    m_previewDebounce = new QTimer(this);
+    m_previewDebounce->setSingleShot(true);
+    m_previewDebounce->setInterval(kPreviewDebounceMs);
+    connect(m_previewDebounce, &QTimer::timeout, this, &MainWindow::startPreview);
+
+    m_previewPlayer = new QTimer(this);
+    connect(m_previewPlayer, &QTimer::timeout, this, [this] {
+        if (m_previewFrames.isEmpty() || !ui->lblPreview) return;
+        m_previewIndex = (m_previewIndex + 1) % m_previewFrames.size();
+        ui->lblPreview->setPixmap(m_previewFrames[m_previewIndex]);
+    });
+
+    connect(m_chkLivePreview, &QCheckBox::toggled, this, [this](bool on) {
+        QSettings s("MyCompany", "GifMaker");
+        s.setValue("livePreview", on);
+        if (on) {
+            schedulePreview();
+        } else {
+            stopPreview();
+            refreshPreview(ui->editImagePath ? ui->editImagePath->text().trimmed() : QString());
+        }
+    });
+
+    // Every control that changes the animation (output size does not: the proxy has its own)
+    auto changed = [this] { schedulePreview(); };
+    for (QLineEdit *e : { ui->editImagePath, ui->editBackPath })
+        if (e) connect(e, &QLineEdit::textChanged, this, changed);
+    for (QComboBox *c : { ui->comboBackground, ui->comboGlobeAxis })
+        if (c) connect(c, qOverload<int>(&QComboBox::currentIndexChanged), this, changed);
+    for (QSpinBox *sb : { ui->spinFPS, ui->spinMaxDegrees })
+        if (sb) connect(sb, qOverload<int>(&QSpinBox::valueChanged), this, changed);
+    for (QDoubleSpinBox *sb : { ui->spinDuration, ui->spinYawMax, ui->spinYawMax_2,
+                                ui->spinGlobeRotations, ui->spinGlobeZoom })
+        if (sb) connect(sb, qOverload<double>(&QDoubleSpinBox::valueChanged), this, changed);
+    for (QAbstractButton *b : std::initializer_list<QAbstractButton *>{
+             ui->radioSpin, ui->radioOscillate, ui->radioFlipUD, ui->radioYawSpin, ui->radioGlobe,
+             ui->radioSimBackface, ui->radioSimBackfaceUpsideDown, ui->checkCropToContent })
+        if (b) connect(b, &QAbstractButton::toggled, this, changed);
+}
+
+// Restarts the debounce; the proxy renders once the settings stop changing
+void MainWindow::schedulePreview()
+{
+    if (m_chkLivePreview && m_chkLivePreview->isChecked())
+        m_previewDebounce->start();
+}
+
+void MainWindow::startPreview()
+{
+    if (!m_chkLivePreview->isChecked() || m_genThread) return;
+
+    // A stale proxy is still rendering: stop it, start over when it returns
+    if (m_previewThread) {
+        m_previewCancel = true;
+        m_previewPending = true;
+        return;
+    }
+
+    const QString src = ui->editImagePath ? ui->editImagePath->text().trimmed() : QString();
+    if (src.isEmpty() || !QFileInfo::exists(src)) return;
+    const std::function<bool(GifEngine &, QString *)> run =
+        makeRun(src, QString(), kPreviewSizePx, kPreviewMaxFps);
+    if (!run) return;
+
+    const int fps = qMin(ui->spinFPS ? ui->spinFPS->value() : 24, kPreviewMaxFps);
+    m_previewPlayer->setInterval(qMax(10, 1000 / qMax(1, fps)));
+
+    GifEngine engine = makeEngine();
+    m_previewCancel  = false;
+    m_previewPending = false;
+    m_previewOk      = false;
+    m_previewRendered.clear();
+    engine.setCancelFlag(&m_previewCancel);
+    engine.setFrameSink([this](const QImage &frame) { m_previewRendered.append(frame); });
+
+    m_previewThread = QThread::create([this, engine, run]() mutable {
+        QString err;
+        m_previewOk = run(engine, &err);   // read by finishPreview()
+    });
+    connect(m_previewThread, &QThread::finished, this, &MainWindow::finishPreview);
+    m_previewThread->start();
+}
+
+void MainWindow::finishPreview()
+{
+    m_previewThread->wait();
+    delete m_previewThread;
+    m_previewThread = nullptr;
+
+    if (m_previewPending) {
+        startPreview();
+        return;
+    }
+    if (!m_previewOk || m_previewRendered.isEmpty() || !ui->lblPreview) return;
+
+    // Proxy frames, scaled up once for display
+    m_previewFrames.clear();
+    for (const QImage &frame : std::as_const(m_previewRendered))
+        m_previewFrames.append(QPixmap::fromImage(frame.scaled(kPreviewDisplayPx, kPreviewDisplayPx,
+                                                               Qt::KeepAspectRatio,
+                                                               Qt::SmoothTransformation)));
+    m_previewRendered.clear();
+
+    if (auto *old = ui->lblPreview->movie()) {
+        old->stop();
+        old->deleteLater();
+    }
+    m_previewIndex = 0;
+    ui->lblPreview->setPixmap(m_previewFrames.first());
+    m_previewPlayer->start();
+}
+
+void MainWindow::stopPreview()
+{
+    m_previewDebounce->stop();
+    m_previewPlayer->stop();
+    m_previewFrames.clear();
+    m_previewCancel = true;
+    m_previewPending = false;
+}
@@ -6,8 +6,19 @@
 #include <QImage>
 #include <QColor>
 #include <QPixmap>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include "runprofile.h"
 
 namespace Ui { class MainWindow; }
+class GifEngine;
+class QThread;
+class QProgressBar;
+class QPushButton;
+class QCheckBox;
+class QLineEdit;
+class QTimer;
 
 class MainWindow : public QMainWindow
 {
@@ -20,112 +31,57 @@ private:
     Ui::MainWindow *ui;
     QPixmap m_previewPixmap;
 
-    // Generators you’re calling from .cpp
-    bool generateSpinGif(const QString &srcImagePath,
-                         const QString &outGifPath,
-                         int fps, int durationSec, int sizePx,
-                         const QColor &bg, QString *errOut);
-
-    bool generateOscillateGif(const QString &srcImagePath,
-                              const QString &outGifPath,
-                              int fps, int durationSec, int sizePx,
-                              qreal maxDegrees,
-                              const QColor &bg, QString *errOut);
-
-    bool generateYawSpinGif(const QString &srcImagePath,
-                            const QString &outGifPath,
-                            int fps, int durationSec, int sizePx,
-                            qreal maxYawDeg,
-                            const QColor &bg, QString *errOut);
-
-    bool generateFlipGif(const QString &srcImagePath,
-                         const QString &outGifPath,
-                         int fps, int durationSec, int sizePx,
-                         bool animate, int cycles,
-                         const QColor &bg, QString *errOut);
-
-    bool generateCompositeGif(const QString &srcImagePath,
-                              const QString &outGifPath,
-                              int fps, int durationSec, int sizePx,
-                              bool useZSpin, qreal zDegPerSec,
-                              bool useYaw, qreal maxYawDeg,
-                              bool useFlip, bool flipAnimate, int flipCycles,
-                              const QColor &bg, QString *errOut);
-
-    // (Optional) globe helpers if your .cpp really uses them
-    bool generateGlobeGif(const QString &frontImagePath,
-                          const QString &backImagePath,
-                          const QString &outGifPath,
-                          int fps, int durationSec, int sizePx,
-                          qreal rotationSpeed, qreal zoomPercent,
-                          int rotationAxis,
-                          const QColor &globeSurfaceColor,
-                          QString *errOut);
-
-    QImage renderGlobeFrame(const QImage &frontTexture,
-                            const QImage &backTexture,
-                            qreal rotationDegrees, int sizePx,
-                            const QColor &frameBg,
-                            const QColor &globeSurfaceColor,
-                            bool enableLighting,
-                            int rotationAxis);
-
-    QImage renderGlobeFrame(const QImage &frontTexture,
-                            const QImage &backTexture,
-                            qreal rotationDegrees, int sizePx,
-                            const QColor &bg, bool enableLighting, int rotationAxis);
-
-    QRgb sampleTexture(const QImage &frontTexture,
-                       const QImage &backTexture,
-                       qreal lon, qreal lat);
-
-    QRgb sampleTexture(const QImage &frontTexture,
-                       const QImage &backTexture,
-                       qreal lon, qreal lat,
-                       const QColor &fallbackColor);
+    // Engine configured from the current UI state (back image, crop, backside mode)
+    GifEngine makeEngine();
+
+    // Generator call for the current UI settings (empty if no mode is selected)
+    std::function<bool(GifEngine &, QString *)> makeRun(const QString &src, const QString &out,
+                                                        int sizeOverride = 0, int maxFps = 0) const;
+
+    // Background generation (one at a time)
+    void startGeneration(const std::function<bool(GifEngine &, QString *)> &run,
+                         const QString &outGifPath);
+    void finishGeneration(const QString &outGifPath);
+    void cancelGeneration();
+    void setGenerating(bool on);
+    void showProgress(int done, int total);
+
+    QThread          *m_genThread = nullptr;
+    std::atomic<bool> m_cancel { false };
+    bool              m_genOk = false;
+    QString           m_genError;
+    int               m_genFrames = 0;
+    RunProfile        m_genProfile;   // per-stage timing of the current run
+    QProgressBar     *m_progressBar = nullptr;
+    QPushButton      *m_btnCancel = nullptr;
+    QLineEdit        *m_editOutputSizes = nullptr;   // extra sizes, e.g. "128, 256"
+
+    // Live preview: a small, low-fps proxy of the current settings played in
+    // lblPreview, re-rendered (debounced) whenever a parameter changes
+    void setupLivePreview();
+    void schedulePreview();
+    void startPreview();
+    void finishPreview();
+    void stopPreview();
+
+    QCheckBox        *m_chkLivePreview = nullptr;
+    QTimer           *m_previewDebounce = nullptr;
+    QTimer           *m_previewPlayer = nullptr;
+    QThread          *m_previewThread = nullptr;
+    std::atomic<bool> m_previewCancel { false };
+    bool              m_previewPending = false;   // settings changed while a preview was rendering
+    bool              m_previewOk = false;
+    QVector<QImage>   m_previewRendered;           // filled by the preview thread
+    QVector<QPixmap>  m_previewFrames;
+    int               m_previewIndex = 0;
 
     // UI helpers
-    QImage  zoomImage(const QImage &src, qreal zoomPercent, const QColor &padColor);
     QImage  cropCenterPercent(const QImage &src, qreal percentToKeep);
     void    refreshPreview(const QString &path);
     QString pickImageWithPreview(const QString &startDir);
     void    showGifInPreview(const QString &gifPath);
 
-QString ensureBackImageForRun(const QString &frontPath,
-                                          const QString &explicitBackPath,
-                                          bool simulateBack,
-                                          QString *errOut);
-
-bool resolveFrontBackImages(const QString &frontPath,
-                                        const QString &maybeBackPath,
-                                        QImage &frontOut,
-                                        QImage &backOut,
-                                        QString *errOut);
-
-const QImage &pickFaceForAngle(const QImage &front,
-                                           const QImage &back,
-                                           qreal angleDeg) const;
-
-bool generateSpinGif(const QString &frontPath,
-                                 const QString &backPath,
-                                 const QString &outDir,
-                                 int fps,
-                                 int durationSec,
-                                 qreal maxAngleDeg,
-                                 int cycles,
-                                 QString *errOut);
-
-bool generateFlipGif(const QString &frontPath,
-                                 const QString &backPath,
-                                 const QString &outDir,
-                                 int fps,
-                                 int durationSec,
-                                 qreal maxAngleDeg,
-                                 int cycles,
-                                 QString *errOut);
-
 bool simulateBacksideEnabled() const;
-QImage makeBacksideFrom(const QImage &front, bool *ok, QString *errOut);
 void appendLog(const QString &msg);
 void on_radioSimBackface_toggled(bool checked);
 void setupBackfaceRadios();
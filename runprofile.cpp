@@ -0,0 +1,334 @@
+#include "runprofile.h"
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStringList>
+#include <QThread>
+#include <QtGlobal>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// --- Helper: CPU time of the calling thread, ns (0 if unavailable)
+static qint64 threadCpuNs()
+{
+#ifdef Q_OS_WIN
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) return 0;
+    const quint64 k = (quint64(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    const quint64 u = (quint64(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return qint64((k + u) * 100);   // 100 ns units
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+// --- Helper: lock-free max / min on an atomic
+static void raiseTo(std::atomic<qint64> &value, qint64 candidate)
+{
+    qint64 cur = value.load();
+    while (candidate > cur && !value.compare_exchange_weak(cur, candidate)) {}
+}
+
+static void lowerTo(std::atomic<qint64> &value, qint64 candidate)
+{
+    qint64 cur = value.load();
+    while ((cur < 0 || candidate < cur) && !value.compare_exchange_weak(cur, candidate)) {}
+}
+
+// --- Helper: "12 ms" / "2.41 s" / "48.0 MB"
+static QString formatNs(qint64 ns)
+{
+    if (ns >= 1000000000) return QStringLiteral("%1 s").arg(ns / 1e9, 0, 'f', 2);
+    return QStringLiteral("%1 ms").arg(ns / 1e6, 0, 'f', ns < 10000000 ? 1 : 0);
+}
+
+static QString formatBytes(qint64 bytes)
+{
+    if (bytes >= 1024 * 1024) return QStringLiteral("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    return QStringLiteral("%1 KB").arg((bytes + 1023) / 1024);
+}
+
+const char *RunProfile::stageName(Stage stage)
+{
+    switch (stage) {
+    case Decode:   return "decode";
+    case Backside: return "backside";
+    case Canvas:   return "canvas";
+    case Render:   return "render";
+    case Quantize: return "quantize";
+    case Encode:   return "encode";
+    case Assemble: return "assemble";
+    default:       return "?";
+    }
+}
+
+RunProfile::Scope::Scope(RunProfile *profile, Stage stage, int frame)
+    : m_profile(profile)
+    , m_stage(stage)
+    , m_frame(frame)
+{
+    if (!m_profile) return;
+    m_profile->m_stages[m_stage].active.fetch_add(1);
+    m_start = m_profile->now();
+    m_cpu   = threadCpuNs();
+}
+
+void RunProfile::Scope::stop(qint64 bytes)
+{
+    if (!m_profile) return;
+    const qint64 end = m_profile->now();
+    Counters &c = m_profile->m_stages[m_stage];
+    c.calls.fetch_add(1);
+    c.wallNs.fetch_add(end - m_start);
+    c.cpuNs.fetch_add(threadCpuNs() - m_cpu);
+    c.bytes.fetch_add(bytes);
+    lowerTo(c.firstNs, m_start);
+    raiseTo(c.lastNs, end);
+    raiseTo(c.peakFrameBytes, m_profile->m_frameBytes.load());
+    c.active.fetch_sub(1);
+    if (m_profile->m_tracing)
+        m_profile->addEvent(stageName(m_stage), 'X', m_start, end - m_start, m_frame);
+    m_profile = nullptr;
+}
+
+RunProfile::TraceScope::TraceScope(RunProfile *profile, const char *name, int frame)
+    : m_profile(profile && profile->m_tracing ? profile : nullptr)
+    , m_name(name)
+    , m_frame(frame)
+{
+    if (m_profile) m_start = m_profile->now();
+}
+
+RunProfile::TraceScope::~TraceScope()
+{
+    if (m_profile) m_profile->addEvent(m_name, 'X', m_start, m_profile->now() - m_start, m_frame);
+}
+
+void RunProfile::reset()
+{
+    for (Counters &c : m_stages) {
+        c.calls = 0;
+        c.active = 0;
+        c.wallNs = 0;
+        c.cpuNs = 0;
+        c.bytes = 0;
+        c.firstNs = -1;
+        c.lastNs = 0;
+        c.peakFrameBytes = 0;
+    }
+    m_frameBytes = 0;
+    m_peakFrameBytes = 0;
+    m_totalNs = -1;
+
+    QMutexLocker lock(&m_traceMutex);
+    m_events.clear();
+    m_threadIds.clear();
+    m_threadNames.clear();
+    m_roleCounts.clear();
+    m_clock.start();
+}
+
+void RunProfile::stop()
+{
+    qint64 expected = -1;
+    m_totalNs.compare_exchange_strong(expected, now());
+}
+
+// The peak is charged to every stage running at that moment
+void RunProfile::frameHeld(qint64 bytes)
+{
+    const qint64 held = m_frameBytes.fetch_add(bytes) + bytes;
+    raiseTo(m_peakFrameBytes, held);
+    for (Counters &c : m_stages)
+        if (c.active.load() > 0) raiseTo(c.peakFrameBytes, held);
+    traceCounter("frame memory", held);
+}
+
+void RunProfile::frameReleased(qint64 bytes)
+{
+    const qint64 held = m_frameBytes.fetch_sub(bytes) - bytes;
+    traceCounter("frame memory", held);
+}
+
+// --- Trace: events are appended under one mutex; a run records a handful
+//     per frame, so contention stays far below the work being measured
+
+int RunProfile::threadIndex()
+{
+    const quintptr id = quintptr(QThread::currentThreadId());
+    const auto it = m_threadIds.constFind(id);
+    if (it != m_threadIds.constEnd()) return it.value();
+    const int tid = m_threadNames.size() + 1;
+    m_threadIds.insert(id, tid);
+    m_threadNames.append(QString());
+    return tid;
+}
+
+void RunProfile::addEvent(const char *name, char phase, qint64 startNs, qint64 durNs, int frame)
+{
+    QMutexLocker lock(&m_traceMutex);
+    m_events.append(TraceEvent{ name, phase, threadIndex(), startNs, durNs, frame });
+}
+
+void RunProfile::traceThread(const char *role)
+{
+    if (!m_tracing) return;
+    QMutexLocker lock(&m_traceMutex);
+    const int tid = threadIndex();
+    if (!m_threadNames[tid - 1].isEmpty()) return;
+    const QString r = QString::fromLatin1(role);
+    const int n = ++m_roleCounts[r];
+    m_threadNames[tid - 1] = n > 1 ? QStringLiteral("%1 %2").arg(r).arg(n) : r;
+}
+
+void RunProfile::traceCounter(const char *name, qint64 value)
+{
+    if (m_tracing) addEvent(name, 'C', now(), value, -1);
+}
+
+// Chrome trace-event format: times in microseconds, one tid per thread,
+// thread names as metadata events
+bool RunProfile::writeTrace(const QString &path, QString *errOut) const
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+
+    QMutexLocker lock(&m_traceMutex);
+    for (int i = 0; i < m_threadNames.size(); ++i) {
+        QJsonObject meta;
+        meta.insert("ph", QStringLiteral("M"));
+        meta.insert("name", QStringLiteral("thread_name"));
+        meta.insert("pid", double(pid));
+        meta.insert("tid", i + 1);
+        const QString name = m_threadNames[i].isEmpty() ? QStringLiteral("thread %1").arg(i + 1)
+                                                        : m_threadNames[i];
+        meta.insert("args", QJsonObject { { "name", name } });
+        events.append(meta);
+    }
+
+    for (const TraceEvent &e : m_events) {
+        QJsonObject o;
+        o.insert("name", QString::fromLatin1(e.name));
+        o.insert("ph", QString(QLatin1Char(e.phase)));
+        o.insert("pid", double(pid));
+        o.insert("tid", e.tid);
+        o.insert("ts", e.startNs / 1000.0);
+        if (e.phase == 'C') {
+            o.insert("args", QJsonObject { { "value", double(e.durNs) } });
+        } else {
+            o.insert("dur", e.durNs / 1000.0);
+            if (e.frame >= 0) o.insert("args", QJsonObject { { "frame", e.frame } });
+        }
+        events.append(o);
+    }
+    lock.unlock();
+
+    QJsonObject doc;
+    doc.insert("traceEvents", events);
+    doc.insert("displayTimeUnit", QStringLiteral("ms"));
+
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (errOut) *errOut = QStringLiteral("Cannot write trace: %1").arg(path);
+        return false;
+    }
+    f.write(QJsonDocument(doc).toJson(QJsonDocument::Compact));
+    if (!f.commit()) {
+        if (errOut) *errOut = QStringLiteral("Cannot write trace: %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+RunProfile::StageStats RunProfile::stage(Stage stage) const
+{
+    const Counters &c = m_stages[stage];
+    StageStats s;
+    s.calls          = c.calls;
+    s.wallNs         = c.wallNs;
+    s.spanNs         = c.firstNs >= 0 ? c.lastNs - c.firstNs : 0;
+    s.cpuNs          = c.cpuNs;
+    s.bytes          = c.bytes;
+    s.peakFrameBytes = c.peakFrameBytes;
+    return s;
+}
+
+qint64 RunProfile::wallNs() const
+{
+    const qint64 total = m_totalNs;
+    return total >= 0 ? total : now();
+}
+
+qint64 RunProfile::cpuNs() const
+{
+    qint64 sum = 0;
+    for (const Counters &c : m_stages) sum += c.cpuNs;
+    return sum;
+}
+
+// Stages that ran on several threads show their CPU time too
+QString RunProfile::summary() const
+{
+    QStringList parts;
+    for (int i = 0; i < StageCount; ++i) {
+        const StageStats s = stage(Stage(i));
+        if (s.calls == 0) continue;
+        QString part = QStringLiteral("%1 %2").arg(QString::fromLatin1(stageName(Stage(i))),
+                                                   formatNs(s.spanNs));
+        if (s.cpuNs > s.spanNs + s.spanNs / 4)
+            part += QStringLiteral(" (cpu %1)").arg(formatNs(s.cpuNs));
+        parts << part;
+    }
+    parts << QStringLiteral("peak frames %1").arg(formatBytes(m_peakFrameBytes));
+    return QStringLiteral("Timing %1: %2").arg(formatNs(wallNs()), parts.join(QStringLiteral(", ")));
+}
+
+QJsonObject RunProfile::toJson() const
+{
+    QJsonObject stages;
+    for (int i = 0; i < StageCount; ++i) {
+        const StageStats s = stage(Stage(i));
+        QJsonObject o;
+        o.insert("calls", s.calls);
+        o.insert("wallMs", s.wallNs / 1e6);
+        o.insert("spanMs", s.spanNs / 1e6);
+        o.insert("cpuMs", s.cpuNs / 1e6);
+        o.insert("bytes", double(s.bytes));
+        o.insert("peakFrameBytes", double(s.peakFrameBytes));
+        stages.insert(QString::fromLatin1(stageName(Stage(i))), o);
+    }
+
+    QJsonObject r;
+    r.insert("wallMs", wallNs() / 1e6);
+    r.insert("cpuMs", cpuNs() / 1e6);
+    r.insert("peakFrameBytes", double(m_peakFrameBytes));
+    r.insert("stages", stages);
+    return r;
+}
+
+bool RunProfile::writeJson(const QString &path, const QJsonObject &extra, QString *errOut) const
+{
+    QJsonObject report = extra;
+    const QJsonObject timing = toJson();
+    for (const QString &key : timing.keys())
+        report.insert(key, timing.value(key));
+
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (errOut) *errOut = QStringLiteral("Cannot write report: %1").arg(path);
+        return false;
+    }
+    f.write(QJsonDocument(report).toJson(QJsonDocument::Indented));
+    if (!f.commit()) {
+        if (errOut) *errOut = QStringLiteral("Cannot write report: %1").arg(path);
+        return false;
+    }
+    return true;
+}
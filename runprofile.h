@@ -0,0 +1,175 @@
+#ifndef RUNPROFILE_H
+#define RUNPROFILE_H
+
+#include <QString>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <atomic>
+
+// Per-stage timing and memory for one generator run.
+//
+// GifEngine and FramePipeline open a Scope around each piece of work; the
+// profile adds it up per stage, from any number of threads at once:
+//
+//  Decode   - loading the source (and back) images
+//  Backside - simulating the back face (makeBacksideFrom)
+//  Canvas   - crop, square canvases, zoom, warp and sampler setup
+//  Render   - drawing frames (on the render workers)
+//  Quantize - global palette and per-frame colour reduction
+//  Encode   - GIF compression, or PNG frames for ImageMagick (writeFrames)
+//  Assemble - the ImageMagick run
+//
+// Per stage: calls, wall time summed over threads, span (first start to last
+// end), thread CPU time, bytes produced (decoded pixels, canvases, frames,
+// encoded output) and the peak frame memory while the stage was running.
+// Frame memory is what the pipeline holds between render and encode
+// (queue, reorder buffer, frames kept for reuse).
+//
+// With setTracing(true) every scope is also kept as a timeline event (with
+// its frame index and thread), together with the pipeline's waits (queue
+// full/empty, frames arriving out of order) and counters (queue depth, frame
+// memory). writeTrace() saves them as Chrome trace-event JSON, for
+// chrome://tracing or ui.perfetto.dev.
+//
+//   RunProfile profile;
+//   engine.setProfile(&profile);
+//   engine.generateSpinGif(...);
+//   profile.stop();
+//   log(profile.summary());
+class RunProfile
+{
+public:
+    enum Stage { Decode, Backside, Canvas, Render, Quantize, Encode, Assemble, StageCount };
+    static const char *stageName(Stage stage);
+
+    // Times one piece of work in 'stage' on the calling thread, until stop()
+    // or destruction. A null profile makes it a no-op. 'frame' labels the
+    // trace event (-1 = not about one frame).
+    class Scope
+    {
+    public:
+        Scope(RunProfile *profile, Stage stage, int frame = -1);
+        ~Scope() { stop(); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        // Ends the scope early; 'bytes' is what the work produced
+        void stop(qint64 bytes = 0);
+
+    private:
+        RunProfile *m_profile;
+        Stage       m_stage;
+        int         m_frame;
+        qint64      m_start = 0;   // ns since the profile's start
+        qint64      m_cpu = 0;
+    };
+
+    // Trace-only span, e.g. a thread blocked on a queue; no-op unless tracing.
+    // 'name' must be a string literal (it is kept, not copied).
+    class TraceScope
+    {
+    public:
+        TraceScope(RunProfile *profile, const char *name, int frame = -1);
+        ~TraceScope();
+        TraceScope(const TraceScope &) = delete;
+        TraceScope &operator=(const TraceScope &) = delete;
+
+    private:
+        RunProfile *m_profile;
+        const char *m_name;
+        int         m_frame;
+        qint64      m_start = 0;
+    };
+
+    struct StageStats {
+        int    calls = 0;
+        qint64 wallNs = 0;          // summed over threads
+        qint64 spanNs = 0;          // first start to last end
+        qint64 cpuNs = 0;           // thread CPU time
+        qint64 bytes = 0;
+        qint64 peakFrameBytes = 0;
+    };
+
+    RunProfile() { reset(); }
+
+    // Clears everything and restarts the clock (not while a run is using it)
+    void reset();
+    // Freezes the total wall time; called once the run is over
+    void stop();
+
+    // Frame memory held by the pipeline, counted when taken and when let go
+    void frameHeld(qint64 bytes);
+    void frameReleased(qint64 bytes);
+
+    // Timeline recording (off by default); set before the run starts
+    void setTracing(bool on) { m_tracing = on; }
+    bool isTracing() const { return m_tracing; }
+
+    // Names the calling thread in the trace ("encoder", "render", ...);
+    // threads of the same role are numbered. The first role sticks.
+    void traceThread(const char *role);
+
+    // Counter track in the trace (e.g. queue depth); no-op unless tracing
+    void traceCounter(const char *name, qint64 value);
+
+    // Trace-event JSON ({"traceEvents": [...]}), loadable in chrome://tracing
+    // and Perfetto
+    bool writeTrace(const QString &path, QString *errOut) const;
+
+    StageStats stage(Stage stage) const;
+    qint64 wallNs() const;
+    qint64 cpuNs() const;                // all stages
+    qint64 peakFrameBytes() const { return m_peakFrameBytes; }
+
+    // One line for the log / statusbar: "decode 12 ms, render 340 ms (cpu 2.41 s), ..."
+    QString summary() const;
+
+    // {"wallMs":..., "cpuMs":..., "peakFrameBytes":..., "stages": {"decode": {...}, ...}}
+    QJsonObject toJson() const;
+
+    // toJson() plus the keys of 'extra' (source, output, ...), as a file
+    bool writeJson(const QString &path, const QJsonObject &extra, QString *errOut) const;
+
+private:
+    struct Counters {
+        std::atomic<int>    calls { 0 };
+        std::atomic<int>    active { 0 };
+        std::atomic<qint64> wallNs { 0 };
+        std::atomic<qint64> cpuNs { 0 };
+        std::atomic<qint64> bytes { 0 };
+        std::atomic<qint64> firstNs { 0 };
+        std::atomic<qint64> lastNs { 0 };
+        std::atomic<qint64> peakFrameBytes { 0 };
+    };
+
+    struct TraceEvent {
+        const char *name;
+        char        phase;     // 'X' span, 'C' counter
+        int         tid;
+        qint64      startNs;
+        qint64      durNs;     // span length, or the counter value
+        int         frame;
+    };
+
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+    void addEvent(const char *name, char phase, qint64 startNs, qint64 durNs, int frame);
+    int  threadIndex();        // call with m_traceMutex held
+
+    QElapsedTimer       m_clock;
+    std::atomic<qint64> m_totalNs { -1 };       // -1 while running
+    std::atomic<qint64> m_frameBytes { 0 };
+    std::atomic<qint64> m_peakFrameBytes { 0 };
+    Counters            m_stages[StageCount];
+
+    bool                m_tracing = false;
+    mutable QMutex      m_traceMutex;
+    QVector<TraceEvent> m_events;
+    QHash<quintptr, int> m_threadIds;          // thread -> trace tid
+    QVector<QString>    m_threadNames;         // by tid - 1; empty until named
+    QHash<QString, int> m_roleCounts;
+};
+
+#endif // RUNPROFILE_H
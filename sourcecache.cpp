@@ -0,0 +1,98 @@
+#include "sourcecache.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSettings>
+
+namespace {
+
+QMutex                 g_cacheMutex;
+QHash<QString, QImage> g_cache;
+QList<QString>         g_cacheOrder;       // least recently used first
+qint64                 g_cacheBytes = 0;
+qint64                 g_capacity   = -1;  // -1 = not read from the settings yet
+
+// --- Helper: capacity, from the "sourceCacheMB" setting on first use
+//     (call with g_cacheMutex held)
+static qint64 capacityLocked()
+{
+    if (g_capacity < 0) {
+        QSettings s("MyCompany", "GifMaker");
+        g_capacity = qMax(0, s.value("sourceCacheMB", 256).toInt()) * 1024ll * 1024;
+    }
+    return g_capacity;
+}
+
+static void evictLocked()
+{
+    const qint64 cap = capacityLocked();
+    while (g_cacheBytes > cap && !g_cacheOrder.isEmpty()) {
+        const QImage img = g_cache.take(g_cacheOrder.takeFirst());
+        g_cacheBytes -= img.sizeInBytes();
+    }
+}
+
+} // namespace
+
+QString SourceCache::fileKey(const QString &path)
+{
+    const QFileInfo fi(path);
+    if (!fi.exists()) return QString();
+    return QStringLiteral("%1|%2|%3")
+        .arg(fi.canonicalFilePath())
+        .arg(fi.lastModified().toMSecsSinceEpoch())
+        .arg(fi.size());
+}
+
+QImage SourceCache::get(const QString &key, const std::function<QImage()> &make)
+{
+    if (!key.isEmpty()) {
+        QMutexLocker lock(&g_cacheMutex);
+        const auto it = g_cache.constFind(key);
+        if (it != g_cache.constEnd()) {
+            g_cacheOrder.removeOne(key);
+            g_cacheOrder.append(key);
+            return it.value();
+        }
+    }
+
+    const QImage img = make();
+    if (key.isEmpty() || img.isNull()) return img;
+
+    QMutexLocker lock(&g_cacheMutex);
+    if (img.sizeInBytes() > capacityLocked() || g_cache.contains(key)) return img;
+    g_cache.insert(key, img);
+    g_cacheOrder.append(key);
+    g_cacheBytes += img.sizeInBytes();
+    evictLocked();
+    return img;
+}
+
+void SourceCache::setCapacity(qint64 bytes)
+{
+    QMutexLocker lock(&g_cacheMutex);
+    g_capacity = qMax<qint64>(0, bytes);
+    evictLocked();
+}
+
+qint64 SourceCache::capacity()
+{
+    QMutexLocker lock(&g_cacheMutex);
+    return capacityLocked();
+}
+
+qint64 SourceCache::usedBytes()
+{
+    QMutexLocker lock(&g_cacheMutex);
+    return g_cacheBytes;
+}
+
+void SourceCache::clear()
+{
+    QMutexLocker lock(&g_cacheMutex);
+    g_cache.clear();
+    g_cacheOrder.clear();
+    g_cacheBytes = 0;
+}
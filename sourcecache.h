@@ -0,0 +1,36 @@
+#ifndef SOURCECACHE_H
+#define SOURCECACHE_H
+
+#include <QString>
+#include <QImage>
+#include <functional>
+
+// Process-wide LRU cache of decoded and prepared source images.
+//
+// A generate click used to decode the front image up to three times and
+// redo crop + square canvas every time, although only the motion parameters
+// had changed. GifEngine now asks this cache instead: keys start with
+// fileKey() (path, modification time and size, so an edited file is a new
+// entry) followed by the preparation parameters.
+//
+// Entries are evicted least recently used first once the cache holds more
+// than capacity() bytes ("sourceCacheMB" setting, default 256). Images are
+// implicitly shared, so a hit is a reference, not a copy. Safe to call from
+// several threads; two threads missing the same key both compute it.
+class SourceCache
+{
+public:
+    // "<canonical path>|<mtime ms>|<size>", or empty if the file is missing
+    static QString fileKey(const QString &path);
+
+    // Image for 'key', made by 'make' (outside the lock) on a miss. Null
+    // results are returned but not cached; so are empty keys.
+    static QImage get(const QString &key, const std::function<QImage()> &make);
+
+    static void   setCapacity(qint64 bytes);
+    static qint64 capacity();
+    static qint64 usedBytes();
+    static void   clear();
+};
+
+#endif // SOURCECACHE_H
@@ -0,0 +1,78 @@
+#include "sphereprojection.h"
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtMath>
+
+namespace {
+
+// A run only ever uses one or two sizes; keep a few around for repeated runs.
+constexpr int kMaxCachedSizes = 4;
+
+QMutex g_cacheMutex;
+QHash<int, QSharedPointer<const SphereProjection>> g_cache;
+QList<int> g_cacheOrder;   // least recently used first
+
+// Same sampling as the original per-pixel loop in renderGlobeFrame:
+// pixel corners relative to the frame centre, radius = sizePx / 2.
+static QSharedPointer<const SphereProjection> buildProjection(int sizePx)
+{
+    auto proj = QSharedPointer<SphereProjection>::create();
+    proj->sizePx = sizePx;
+    proj->rows.resize(sizePx);
+
+    const qreal radius  = sizePx / 2.0;
+    const qreal centerX = sizePx / 2.0;
+    const qreal centerY = sizePx / 2.0;
+    const qreal r2      = radius * radius;
+
+    // Disc area ~ pi/4 of the frame
+    const int estimate = int(sizePx * qreal(sizePx) * 0.79) + sizePx;
+    proj->nx.reserve(estimate);
+    proj->ny.reserve(estimate);
+    proj->nz.reserve(estimate);
+
+    for (int py = 0; py < sizePx; ++py) {
+        SphereProjection::Row &row = proj->rows[py];
+        row.offset = proj->nx.size();
+        row.x0 = -1;
+
+        const qreal y = py - centerY;
+        for (int px = 0; px < sizePx; ++px) {
+            const qreal x = px - centerX;
+            const qreal distSq = x*x + y*y;
+            if (distSq > r2) continue;
+
+            if (row.x0 < 0) row.x0 = px;
+            const qreal z = qSqrt(r2 - distSq);
+            proj->nx.append(float(x / radius));
+            proj->ny.append(float(y / radius));
+            proj->nz.append(float(z / radius));
+        }
+        row.count = proj->nx.size() - row.offset;
+        if (row.x0 < 0) row.x0 = 0;
+    }
+    return proj;
+}
+
+} // namespace
+
+QSharedPointer<const SphereProjection> SphereProjection::forSize(int sizePx)
+{
+    QMutexLocker lock(&g_cacheMutex);
+
+    auto it = g_cache.constFind(sizePx);
+    if (it != g_cache.constEnd()) {
+        g_cacheOrder.removeOne(sizePx);
+        g_cacheOrder.append(sizePx);
+        return it.value();
+    }
+
+    QSharedPointer<const SphereProjection> proj = buildProjection(sizePx);
+    g_cache.insert(sizePx, proj);
+    g_cacheOrder.append(sizePx);
+    while (g_cacheOrder.size() > kMaxCachedSizes)
+        g_cache.remove(g_cacheOrder.takeFirst());
+    return proj;
+}
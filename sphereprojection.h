@@ -0,0 +1,27 @@
+#ifndef SPHEREPROJECTION_H
+#define SPHEREPROJECTION_H
+
+#include <QVector>
+#include <QSharedPointer>
+
+// Screen-space geometry of an orthographically projected sphere that fills a
+// sizePx x sizePx frame: which pixels are on the disc and the unit normal at
+// each of them. It is identical for every frame of a globe run, so it is
+// computed once per size and shared (read-only) by all render threads.
+struct SphereProjection
+{
+    struct Row {
+        int x0     = 0;   // first disc pixel on this scanline
+        int count  = 0;   // number of disc pixels
+        int offset = 0;   // index of the first one in nx/ny/nz
+    };
+
+    int sizePx = 0;
+    QVector<Row>   rows;          // one per scanline
+    QVector<float> nx, ny, nz;    // unit normals of disc pixels, row-major
+
+    // Cached per size; safe to call from several threads.
+    static QSharedPointer<const SphereProjection> forSize(int sizePx);
+};
+
+#endif // SPHEREPROJECTION_H
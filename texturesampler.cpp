@@ -0,0 +1,374 @@
+#include "texturesampler.h"
+#include <QtMath>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GIFSTEW_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr quint32 kHalfTurn    = 0x80000000u;   // 180°
+constexpr quint32 kQuarterTurn = 0x40000000u;   //  90°
+
+// Flat copy of the two faces for the row kernels; index 0 = front, 1 = back
+struct SampleParams {
+    const quint32 *atlas;
+    qint32  base[2];
+    qint32  width[2];
+    qint32  height[2];
+    quint32 uShift[2];
+    quint32 fallback;
+};
+
+using RowKernel = void (*)(const SampleParams &, const quint32 *, const quint32 *,
+                           const quint32 *, QRgb *, int);
+
+// --- Scalar kernel (reference; also handles the tails of the SIMD kernels)
+
+static inline quint32 lerpChannel(quint32 c00, quint32 c10, quint32 c01, quint32 c11,
+                                  quint32 w00, quint32 w10, quint32 w01, quint32 w11,
+                                  int shift)
+{
+    return (((c00 >> shift) & 0xFF) * w00 + ((c10 >> shift) & 0xFF) * w10 +
+            ((c01 >> shift) & 0xFF) * w01 + ((c11 >> shift) & 0xFF) * w11 + 32768u) >> 16;
+}
+
+static inline quint32 samplePixel(const SampleParams &p, quint32 lon, quint32 yFront, quint32 yBack)
+{
+    const int face = (lon + kQuarterTurn) > kHalfTurn ? 1 : 0;
+    const quint32 u = lon + p.uShift[face];
+    const quint32 y = face ? yBack : yFront;
+    const quint32 x = quint32((quint64(u) * quint32(p.width[face] - 1)) >> 16);
+
+    const qint32 x0 = qint32(x >> 16);
+    const qint32 y0 = qint32(y >> 16);
+    const qint32 x1 = qMin(x0 + 1, p.width[face] - 1);
+    const qint32 y1 = qMin(y0 + 1, p.height[face] - 1);
+    const quint32 fx = (x >> 8) & 0xFF;
+    const quint32 fy = (y >> 8) & 0xFF;
+
+    const quint32 *row0 = p.atlas + p.base[face] + y0 * p.width[face];
+    const quint32 *row1 = p.atlas + p.base[face] + y1 * p.width[face];
+    const quint32 c00 = row0[x0], c10 = row0[x1];
+    const quint32 c01 = row1[x0], c11 = row1[x1];
+
+    // All corners fully transparent -> padding, use the fallback colour
+    if (((c00 | c10 | c01 | c11) >> 24) == 0) return p.fallback;
+
+    const quint32 w00 = (256 - fx) * (256 - fy);
+    const quint32 w10 = fx * (256 - fy);
+    const quint32 w01 = (256 - fx) * fy;
+    const quint32 w11 = fx * fy;
+
+    return (lerpChannel(c00, c10, c01, c11, w00, w10, w01, w11, 24) << 24) |
+           (lerpChannel(c00, c10, c01, c11, w00, w10, w01, w11, 16) << 16) |
+           (lerpChannel(c00, c10, c01, c11, w00, w10, w01, w11,  8) <<  8) |
+            lerpChannel(c00, c10, c01, c11, w00, w10, w01, w11,  0);
+}
+
+static void sampleRowScalar(const SampleParams &p, const quint32 *lon, const quint32 *yFront,
+                            const quint32 *yBack, QRgb *out, int count)
+{
+    for (int i = 0; i < count; ++i)
+        out[i] = samplePixel(p, lon[i], yFront[i], yBack[i]);
+}
+
+#ifdef GIFSTEW_SIMD_X86
+
+// --- SSE4.1 kernel: 4 pixels per step, texel fetches are scalar loads
+
+__attribute__((target("sse4.1")))
+static inline __m128i lerpChannelSse41(__m128i c00, __m128i c10, __m128i c01, __m128i c11,
+                                       __m128i w00, __m128i w10, __m128i w01, __m128i w11)
+{
+    const __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi32(c00, w00), _mm_mullo_epi32(c10, w10)),
+                                      _mm_add_epi32(_mm_mullo_epi32(c01, w01), _mm_mullo_epi32(c11, w11)));
+    return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(32768)), 16);
+}
+
+__attribute__((target("sse4.1")))
+static void sampleRowSse41(const SampleParams &p, const quint32 *lon, const quint32 *yFront,
+                           const quint32 *yBack, QRgb *out, int count)
+{
+    const __m128i sign    = _mm_set1_epi32(int(kHalfTurn));
+    const __m128i quarter = _mm_set1_epi32(int(kQuarterTurn));
+    const __m128i one     = _mm_set1_epi32(1);
+    const __m128i c255    = _mm_set1_epi32(255);
+    const __m128i c256    = _mm_set1_epi32(256);
+    const __m128i zero    = _mm_setzero_si128();
+
+    const __m128i baseF   = _mm_set1_epi32(p.base[0]),       baseB   = _mm_set1_epi32(p.base[1]);
+    const __m128i widthF  = _mm_set1_epi32(p.width[0]),      widthB  = _mm_set1_epi32(p.width[1]);
+    const __m128i wmaxF   = _mm_set1_epi32(p.width[0] - 1),  wmaxB   = _mm_set1_epi32(p.width[1] - 1);
+    const __m128i hmaxF   = _mm_set1_epi32(p.height[0] - 1), hmaxB   = _mm_set1_epi32(p.height[1] - 1);
+    const __m128i uShiftF = _mm_set1_epi32(int(p.uShift[0])), uShiftB = _mm_set1_epi32(int(p.uShift[1]));
+    const __m128i fallback = _mm_set1_epi32(int(p.fallback));
+
+    alignas(16) qint32 idx[4][4];
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lon + i));
+
+        // Back hemisphere: (lon + 90°) > 180° as unsigned
+        const __m128i back = _mm_cmpgt_epi32(_mm_xor_si128(_mm_add_epi32(l, quarter), sign), zero);
+
+        const __m128i u     = _mm_add_epi32(l, _mm_blendv_epi8(uShiftF, uShiftB, back));
+        const __m128i y     = _mm_blendv_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(yFront + i)),
+                                              _mm_loadu_si128(reinterpret_cast<const __m128i *>(yBack + i)), back);
+        const __m128i base  = _mm_blendv_epi8(baseF,  baseB,  back);
+        const __m128i width = _mm_blendv_epi8(widthF, widthB, back);
+        const __m128i wmax  = _mm_blendv_epi8(wmaxF,  wmaxB,  back);
+        const __m128i hmax  = _mm_blendv_epi8(hmaxF,  hmaxB,  back);
+
+        // x = (u * (width - 1)) >> 16, needs the 64-bit product
+        const __m128i pe = _mm_srli_epi64(_mm_mul_epu32(u, wmax), 16);
+        const __m128i po = _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(u, 32), _mm_srli_epi64(wmax, 32)), 16);
+        const __m128i x  = _mm_blend_epi16(pe, po, 0xCC);
+
+        const __m128i x0 = _mm_srli_epi32(x, 16);
+        const __m128i y0 = _mm_srli_epi32(y, 16);
+        const __m128i x1 = _mm_min_epi32(_mm_add_epi32(x0, one), wmax);
+        const __m128i y1 = _mm_min_epi32(_mm_add_epi32(y0, one), hmax);
+        const __m128i fx = _mm_and_si128(_mm_srli_epi32(x, 8), c255);
+        const __m128i fy = _mm_and_si128(_mm_srli_epi32(y, 8), c255);
+
+        const __m128i row0 = _mm_add_epi32(base, _mm_mullo_epi32(y0, width));
+        const __m128i row1 = _mm_add_epi32(base, _mm_mullo_epi32(y1, width));
+        _mm_store_si128(reinterpret_cast<__m128i *>(idx[0]), _mm_add_epi32(row0, x0));
+        _mm_store_si128(reinterpret_cast<__m128i *>(idx[1]), _mm_add_epi32(row0, x1));
+        _mm_store_si128(reinterpret_cast<__m128i *>(idx[2]), _mm_add_epi32(row1, x0));
+        _mm_store_si128(reinterpret_cast<__m128i *>(idx[3]), _mm_add_epi32(row1, x1));
+
+        const quint32 *a = p.atlas;
+        const __m128i c00 = _mm_setr_epi32(int(a[idx[0][0]]), int(a[idx[0][1]]), int(a[idx[0][2]]), int(a[idx[0][3]]));
+        const __m128i c10 = _mm_setr_epi32(int(a[idx[1][0]]), int(a[idx[1][1]]), int(a[idx[1][2]]), int(a[idx[1][3]]));
+        const __m128i c01 = _mm_setr_epi32(int(a[idx[2][0]]), int(a[idx[2][1]]), int(a[idx[2][2]]), int(a[idx[2][3]]));
+        const __m128i c11 = _mm_setr_epi32(int(a[idx[3][0]]), int(a[idx[3][1]]), int(a[idx[3][2]]), int(a[idx[3][3]]));
+
+        const __m128i empty = _mm_cmpeq_epi32(
+            _mm_srli_epi32(_mm_or_si128(_mm_or_si128(c00, c10), _mm_or_si128(c01, c11)), 24), zero);
+
+        const __m128i ifx = _mm_sub_epi32(c256, fx);
+        const __m128i ify = _mm_sub_epi32(c256, fy);
+        const __m128i w00 = _mm_mullo_epi32(ifx, ify);
+        const __m128i w10 = _mm_mullo_epi32(fx,  ify);
+        const __m128i w01 = _mm_mullo_epi32(ifx, fy);
+        const __m128i w11 = _mm_mullo_epi32(fx,  fy);
+
+        const __m128i a_ = lerpChannelSse41(_mm_srli_epi32(c00, 24), _mm_srli_epi32(c10, 24),
+                                            _mm_srli_epi32(c01, 24), _mm_srli_epi32(c11, 24),
+                                            w00, w10, w01, w11);
+        const __m128i r_ = lerpChannelSse41(_mm_and_si128(_mm_srli_epi32(c00, 16), c255),
+                                            _mm_and_si128(_mm_srli_epi32(c10, 16), c255),
+                                            _mm_and_si128(_mm_srli_epi32(c01, 16), c255),
+                                            _mm_and_si128(_mm_srli_epi32(c11, 16), c255),
+                                            w00, w10, w01, w11);
+        const __m128i g_ = lerpChannelSse41(_mm_and_si128(_mm_srli_epi32(c00, 8), c255),
+                                            _mm_and_si128(_mm_srli_epi32(c10, 8), c255),
+                                            _mm_and_si128(_mm_srli_epi32(c01, 8), c255),
+                                            _mm_and_si128(_mm_srli_epi32(c11, 8), c255),
+                                            w00, w10, w01, w11);
+        const __m128i b_ = lerpChannelSse41(_mm_and_si128(c00, c255), _mm_and_si128(c10, c255),
+                                            _mm_and_si128(c01, c255), _mm_and_si128(c11, c255),
+                                            w00, w10, w01, w11);
+
+        const __m128i px = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(a_, 24), _mm_slli_epi32(r_, 16)),
+                                        _mm_or_si128(_mm_slli_epi32(g_, 8), b_));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_blendv_epi8(px, fallback, empty));
+    }
+
+    sampleRowScalar(p, lon + i, yFront + i, yBack + i, out + i, count - i);
+}
+
+// --- AVX2 kernel: 8 pixels per step, texel fetches are gathers
+
+__attribute__((target("avx2")))
+static inline __m256i lerpChannelAvx2(__m256i c00, __m256i c10, __m256i c01, __m256i c11,
+                                      __m256i w00, __m256i w10, __m256i w01, __m256i w11)
+{
+    const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(c00, w00), _mm256_mullo_epi32(c10, w10)),
+                                         _mm256_add_epi32(_mm256_mullo_epi32(c01, w01), _mm256_mullo_epi32(c11, w11)));
+    return _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(32768)), 16);
+}
+
+__attribute__((target("avx2")))
+static void sampleRowAvx2(const SampleParams &p, const quint32 *lon, const quint32 *yFront,
+                          const quint32 *yBack, QRgb *out, int count)
+{
+    const __m256i sign    = _mm256_set1_epi32(int(kHalfTurn));
+    const __m256i quarter = _mm256_set1_epi32(int(kQuarterTurn));
+    const __m256i one     = _mm256_set1_epi32(1);
+    const __m256i c255    = _mm256_set1_epi32(255);
+    const __m256i c256    = _mm256_set1_epi32(256);
+    const __m256i zero    = _mm256_setzero_si256();
+
+    const __m256i baseF   = _mm256_set1_epi32(p.base[0]),       baseB   = _mm256_set1_epi32(p.base[1]);
+    const __m256i widthF  = _mm256_set1_epi32(p.width[0]),      widthB  = _mm256_set1_epi32(p.width[1]);
+    const __m256i wmaxF   = _mm256_set1_epi32(p.width[0] - 1),  wmaxB   = _mm256_set1_epi32(p.width[1] - 1);
+    const __m256i hmaxF   = _mm256_set1_epi32(p.height[0] - 1), hmaxB   = _mm256_set1_epi32(p.height[1] - 1);
+    const __m256i uShiftF = _mm256_set1_epi32(int(p.uShift[0])), uShiftB = _mm256_set1_epi32(int(p.uShift[1]));
+    const __m256i fallback = _mm256_set1_epi32(int(p.fallback));
+    const int *atlas = reinterpret_cast<const int *>(p.atlas);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lon + i));
+
+        // Back hemisphere: (lon + 90°) > 180° as unsigned
+        const __m256i back = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_add_epi32(l, quarter), sign), zero);
+
+        const __m256i u     = _mm256_add_epi32(l, _mm256_blendv_epi8(uShiftF, uShiftB, back));
+        const __m256i y     = _mm256_blendv_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(yFront + i)),
+                                                 _mm256_loadu_si256(reinterpret_cast<const __m256i *>(yBack + i)), back);
+        const __m256i base  = _mm256_blendv_epi8(baseF,  baseB,  back);
+        const __m256i width = _mm256_blendv_epi8(widthF, widthB, back);
+        const __m256i wmax  = _mm256_blendv_epi8(wmaxF,  wmaxB,  back);
+        const __m256i hmax  = _mm256_blendv_epi8(hmaxF,  hmaxB,  back);
+
+        // x = (u * (width - 1)) >> 16, needs the 64-bit product
+        const __m256i pe = _mm256_srli_epi64(_mm256_mul_epu32(u, wmax), 16);
+        const __m256i po = _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(u, 32), _mm256_srli_epi64(wmax, 32)), 16);
+        const __m256i x  = _mm256_blend_epi32(pe, po, 0xAA);
+
+        const __m256i x0 = _mm256_srli_epi32(x, 16);
+        const __m256i y0 = _mm256_srli_epi32(y, 16);
+        const __m256i x1 = _mm256_min_epi32(_mm256_add_epi32(x0, one), wmax);
+        const __m256i y1 = _mm256_min_epi32(_mm256_add_epi32(y0, one), hmax);
+        const __m256i fx = _mm256_and_si256(_mm256_srli_epi32(x, 8), c255);
+        const __m256i fy = _mm256_and_si256(_mm256_srli_epi32(y, 8), c255);
+
+        const __m256i row0 = _mm256_add_epi32(base, _mm256_mullo_epi32(y0, width));
+        const __m256i row1 = _mm256_add_epi32(base, _mm256_mullo_epi32(y1, width));
+        const __m256i c00 = _mm256_i32gather_epi32(atlas, _mm256_add_epi32(row0, x0), 4);
+        const __m256i c10 = _mm256_i32gather_epi32(atlas, _mm256_add_epi32(row0, x1), 4);
+        const __m256i c01 = _mm256_i32gather_epi32(atlas, _mm256_add_epi32(row1, x0), 4);
+        const __m256i c11 = _mm256_i32gather_epi32(atlas, _mm256_add_epi32(row1, x1), 4);
+
+        const __m256i empty = _mm256_cmpeq_epi32(
+            _mm256_srli_epi32(_mm256_or_si256(_mm256_or_si256(c00, c10), _mm256_or_si256(c01, c11)), 24), zero);
+
+        const __m256i ifx = _mm256_sub_epi32(c256, fx);
+        const __m256i ify = _mm256_sub_epi32(c256, fy);
+        const __m256i w00 = _mm256_mullo_epi32(ifx, ify);
+        const __m256i w10 = _mm256_mullo_epi32(fx,  ify);
+        const __m256i w01 = _mm256_mullo_epi32(ifx, fy);
+        const __m256i w11 = _mm256_mullo_epi32(fx,  fy);
+
+        const __m256i a_ = lerpChannelAvx2(_mm256_srli_epi32(c00, 24), _mm256_srli_epi32(c10, 24),
+                                           _mm256_srli_epi32(c01, 24), _mm256_srli_epi32(c11, 24),
+                                           w00, w10, w01, w11);
+        const __m256i r_ = lerpChannelAvx2(_mm256_and_si256(_mm256_srli_epi32(c00, 16), c255),
+                                           _mm256_and_si256(_mm256_srli_epi32(c10, 16), c255),
+                                           _mm256_and_si256(_mm256_srli_epi32(c01, 16), c255),
+                                           _mm256_and_si256(_mm256_srli_epi32(c11, 16), c255),
+                                           w00, w10, w01, w11);
+        const __m256i g_ = lerpChannelAvx2(_mm256_and_si256(_mm256_srli_epi32(c00, 8), c255),
+                                           _mm256_and_si256(_mm256_srli_epi32(c10, 8), c255),
+                                           _mm256_and_si256(_mm256_srli_epi32(c01, 8), c255),
+                                           _mm256_and_si256(_mm256_srli_epi32(c11, 8), c255),
+                                           w00, w10, w01, w11);
+        const __m256i b_ = lerpChannelAvx2(_mm256_and_si256(c00, c255), _mm256_and_si256(c10, c255),
+                                           _mm256_and_si256(c01, c255), _mm256_and_si256(c11, c255),
+                                           w00, w10, w01, w11);
+
+        const __m256i px = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(a_, 24), _mm256_slli_epi32(r_, 16)),
+                                           _mm256_or_si256(_mm256_slli_epi32(g_, 8), b_));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_blendv_epi8(px, fallback, empty));
+    }
+
+    sampleRowScalar(p, lon + i, yFront + i, yBack + i, out + i, count - i);
+}
+
+#endif // GIFSTEW_SIMD_X86
+
+static RowKernel pickRowKernel()
+{
+#ifdef GIFSTEW_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))   return sampleRowAvx2;
+    if (__builtin_cpu_supports("sse4.1")) return sampleRowSse41;
+#endif
+    return sampleRowScalar;
+}
+
+} // namespace
+
+TextureSampler::TextureSampler(const QImage &frontTexture,
+                               const QImage &backTexture,
+                               const QColor &fallbackColor)
+    : m_fallback(fallbackColor.rgba())
+{
+    if (frontTexture.isNull()) return;
+
+    const QImage front = frontTexture.convertToFormat(QImage::Format_ARGB32);
+    const QImage back  = backTexture.isNull() ? QImage()
+                                              : backTexture.convertToFormat(QImage::Format_ARGB32);
+
+    const qint64 frontTexels = qint64(front.width()) * front.height();
+    const qint64 backTexels  = back.isNull() ? 0 : qint64(back.width()) * back.height();
+    m_atlas.resize(int(frontTexels + backTexels));
+
+    // Rows packed back to back, stride == width
+    auto pack = [this](const QImage &img, qint32 base) {
+        for (int y = 0; y < img.height(); ++y)
+            std::memcpy(m_atlas.data() + base + qint64(y) * img.width(),
+                        img.constScanLine(y), size_t(img.width()) * sizeof(quint32));
+    };
+
+    m_face[0].base   = 0;
+    m_face[0].width  = front.width();
+    m_face[0].height = front.height();
+    m_face[0].uShift = kHalfTurn;      // lon 0 is the middle of the front texture
+    pack(front, 0);
+
+    if (back.isNull()) {
+        // Single-sided: the front texture wraps all the way round
+        m_face[1] = m_face[0];
+    } else {
+        m_face[1].base   = qint32(frontTexels);
+        m_face[1].width  = back.width();
+        m_face[1].height = back.height();
+        m_face[1].uShift = 0;          // lon 180° is the middle of the back texture
+        pack(back, m_face[1].base);
+    }
+}
+
+void TextureSampler::sampleRow(const quint32 *lon,
+                               const quint32 *yFront,
+                               const quint32 *yBack,
+                               QRgb *out, int count) const
+{
+    if (isNull()) {
+        for (int i = 0; i < count; ++i) out[i] = m_fallback;
+        return;
+    }
+
+    static const RowKernel kernel = pickRowKernel();
+
+    SampleParams p;
+    p.atlas = m_atlas.constData();
+    for (int f = 0; f < 2; ++f) {
+        p.base[f]   = m_face[f].base;
+        p.width[f]  = m_face[f].width;
+        p.height[f] = m_face[f].height;
+        p.uShift[f] = m_face[f].uShift;
+    }
+    p.fallback = m_fallback;
+
+    kernel(p, lon, yFront, yBack, out, count);
+}
+
+quint32 TextureSampler::turnsFor(qreal lonRadians)
+{
+    // 2^32 turns per 2*pi; the cast wraps any angle into [0, 2^32)
+    return quint32(qRound64(lonRadians * (4294967296.0 / (2.0 * M_PI))));
+}
+
+quint32 TextureSampler::rowFor(qreal latRadians, int texHeight)
+{
+    const qreal v = qBound<qreal>(0.0, (latRadians + M_PI / 2.0) / M_PI, 1.0);   // 0 to 1
+    return quint32(qRound64(v * (qMax(1, texHeight) - 1) * 65536.0));
+}
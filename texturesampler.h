@@ -0,0 +1,57 @@
+#ifndef TEXTURESAMPLER_H
+#define TEXTURESAMPLER_H
+
+#include <QImage>
+#include <QColor>
+#include <QVector>
+
+// Bilinear sampler for the globe's front/back equirectangular textures.
+//
+// Both textures are copied into one packed ARGB32 atlas, so the hemisphere
+// split is just a different base offset and width per pixel. That lets whole
+// rows be sampled in SIMD lanes (AVX2 or SSE4.1, picked at runtime, with a
+// scalar fallback) without branching on front/back.
+//
+// All paths use the same 16.16 fixed-point arithmetic and return identical
+// results. Like the old MainWindow::sampleTexture, the result is the raw
+// (non-premultiplied) interpolated texel, and a spot where all four texels are
+// fully transparent returns the fallback colour.
+class TextureSampler
+{
+public:
+    TextureSampler(const QImage &frontTexture,
+                   const QImage &backTexture,
+                   const QColor &fallbackColor);
+
+    bool isNull() const { return m_atlas.isEmpty(); }
+
+    // Heights used to turn a latitude into a texel row (see rowFor())
+    int frontHeight() const { return m_face[0].height; }
+    int backHeight()  const { return m_face[1].height; }
+
+    // lon:    longitude in turns (2^32 == 360°, 0 == centre of the front texture)
+    // yFront: texel row in the front texture, 16.16 fixed point
+    // yBack:  texel row in the back texture (front height if single-sided)
+    void sampleRow(const quint32 *lon,
+                   const quint32 *yFront,
+                   const quint32 *yBack,
+                   QRgb *out, int count) const;
+
+    // Conversions for callers working in radians
+    static quint32 turnsFor(qreal lonRadians);              // lon in [-pi, pi]
+    static quint32 rowFor(qreal latRadians, int texHeight); // lat in [-pi/2, pi/2]
+
+private:
+    struct Face {
+        qint32  base   = 0;   // first texel in m_atlas
+        qint32  width  = 0;   // also the row stride
+        qint32  height = 0;
+        quint32 uShift = 0;   // added to lon to get u (turns across the texture)
+    };
+
+    Face             m_face[2];   // [0] front hemisphere, [1] back hemisphere
+    QVector<quint32> m_atlas;
+    quint32          m_fallback = 0;
+};
+
+#endif // TEXTURESAMPLER_H